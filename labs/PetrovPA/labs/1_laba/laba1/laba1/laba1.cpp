@@ -1,24 +1,278 @@
 ﻿#include <iostream>
 #include <ctime>
 #include <string>
-#include <map>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
 #include <stdio.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Гистограмма байтов: плоский массив из 256 счётчиков вместо std::map.
+ * Индекс счётчика — сам байт, поэтому подсчёт не ищет по дереву и не выделяет память.
+ */
+struct LetterHistogram {
+    uint64_t counts[256] = {};
+
+    uint64_t operator[](unsigned char c) const { return counts[c]; }
+};
+
+/*
+ * Число промежуточных гистограмм. Соседние байты попадают в разные гистограммы,
+ * поэтому подряд идущие одинаковые символы не ждут друг друга через память.
+ */
+const int SUB_HISTOGRAMS = 4;
+
+/*
+ * Размер блока, после которого промежуточные 32-битные счётчики сбрасываются
+ * в итоговые 64-битные. Сумма по блоку не превышает 2^30 и не переполняется.
+ */
+const size_t HISTOGRAM_BLOCK = size_t(1) << 30;
+
+/*
+ * Складывает промежуточные гистограммы и добавляет результат в итоговую
+ *
+ * @param sub промежуточные гистограммы.
+ * @param hist итоговая гистограмма.
+ */
+void mergeSubHistograms(const uint32_t(&sub)[SUB_HISTOGRAMS][256], LetterHistogram& hist) {
+#if defined(__AVX2__)
+    for (int i = 0; i < 256; i += 8) {
+        __m256i sum = _mm256_load_si256((const __m256i*)&sub[0][i]);
+        for (int k = 1; k < SUB_HISTOGRAMS; ++k) {
+            sum = _mm256_add_epi32(sum, _mm256_load_si256((const __m256i*)&sub[k][i]));
+        }
+        __m256i lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(sum));
+        __m256i hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(sum, 1));
+        __m256i* dst = (__m256i*)&hist.counts[i];
+        _mm256_storeu_si256(dst, _mm256_add_epi64(_mm256_loadu_si256(dst), lo));
+        _mm256_storeu_si256(dst + 1, _mm256_add_epi64(_mm256_loadu_si256(dst + 1), hi));
+    }
+#elif defined(__ARM_NEON)
+    for (int i = 0; i < 256; i += 4) {
+        uint32x4_t sum = vld1q_u32(&sub[0][i]);
+        for (int k = 1; k < SUB_HISTOGRAMS; ++k) {
+            sum = vaddq_u32(sum, vld1q_u32(&sub[k][i]));
+        }
+        vst1q_u64(&hist.counts[i], vaddw_u32(vld1q_u64(&hist.counts[i]), vget_low_u32(sum)));
+        vst1q_u64(&hist.counts[i + 2], vaddw_u32(vld1q_u64(&hist.counts[i + 2]), vget_high_u32(sum)));
+    }
+#else
+    for (int i = 0; i < 256; ++i) {
+        uint32_t sum = 0;
+        for (int k = 0; k < SUB_HISTOGRAMS; ++k) sum += sub[k][i];
+        hist.counts[i] += sum;
+    }
+#endif
+}
+
+/*
+ * Добавляет в гистограмму байты из буфера
+ *
+ * @param hist гистограмма, в которую добавляются частоты.
+ * @param data указатель на данные.
+ * @param n размер данных в байтах.
+ */
+void countBytes(LetterHistogram& hist, const char* data, size_t n) {
+    alignas(64) uint32_t sub[SUB_HISTOGRAMS][256];
+    const unsigned char* p = (const unsigned char*)data;
+    while (n > 0) {
+        size_t block = n < HISTOGRAM_BLOCK ? n : HISTOGRAM_BLOCK;
+        memset(sub, 0, sizeof(sub));
+        size_t i = 0;
+        // Читаем по 8 байт за раз и раскладываем их по четырём гистограммам.
+        for (; i + 8 <= block; i += 8) {
+            uint64_t w;
+            memcpy(&w, p + i, 8);
+            ++sub[0][w & 0xFF];
+            ++sub[1][(w >> 8) & 0xFF];
+            ++sub[2][(w >> 16) & 0xFF];
+            ++sub[3][(w >> 24) & 0xFF];
+            ++sub[0][(w >> 32) & 0xFF];
+            ++sub[1][(w >> 40) & 0xFF];
+            ++sub[2][(w >> 48) & 0xFF];
+            ++sub[3][w >> 56];
+        }
+        for (; i < block; ++i) ++sub[i % SUB_HISTOGRAMS][p[i]];
+        mergeSubHistograms(sub, hist);
+        p += block;
+        n -= block;
+    }
+}
+
+/*
+ * Генератор псевдослучайных чисел xoshiro256**.
+ * Состояние хранится в объекте, поэтому потоки не делят общий rand().
+ */
+struct Xoshiro256 {
+    uint64_t s[4];
+
+    /*
+     * Инициализирует состояние из seed через splitmix64
+     *
+     * @param seed начальное значение.
+     */
+    explicit Xoshiro256(uint64_t seed) {
+        for (int i = 0; i < 4; ++i) {
+            seed += 0x9E3779B97F4A7C15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            s[i] = z ^ (z >> 31);
+        }
+    }
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    /*
+     * Возвращает следующее 64-битное число
+     */
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+
+/*
+ * Сколько букв извлекается из одного 64-битного числа: 26^13 < 2^64.
+ */
+const int LETTERS_PER_DRAW = 13;
+
+/*
+ * 26^13 и наибольшее кратное ему число, не превышающее 2^64. Числа не меньше
+ * DRAW_LIMIT отбрасываются, поэтому все буквы равновероятны.
+ */
+const uint64_t POW26_13 = 2481152873203736576ull;
+const uint64_t DRAW_LIMIT = POW26_13 * 7;
+
+/*
+ * Размер блока генерации. Каждый блок получает свой поток чисел, зависящий
+ * только от seed и номера блока, поэтому результат не зависит от числа потоков.
+ */
+const size_t GEN_BLOCK = size_t(1) << 20;
+
+/*
+ * Заполняет один блок случайными строчными буквами
+ *
+ * @param out указатель на начало блока.
+ * @param n число букв (не больше GEN_BLOCK).
+ * @param seed начальное значение.
+ * @param block номер блока от начала последовательности.
+ */
+void fillLetterBlock(char* out, size_t n, uint64_t seed, uint64_t block) {
+    Xoshiro256 rng(seed ^ (block * 0xD1B54A32D192ED03ull));
+    size_t i = 0;
+    while (i < n) {
+        uint64_t r = rng.next();
+        if (r >= DRAW_LIMIT) continue;
+        r %= POW26_13;
+        int k = n - i < LETTERS_PER_DRAW ? int(n - i) : LETTERS_PER_DRAW;
+        for (int j = 0; j < k; ++j) {
+            out[i++] = char('a' + r % 26);
+            r /= 26;
+        }
+    }
+}
+
+/*
+ * Заполняет буфер случайными строчными буквами несколькими потоками.
+ * Одинаковый seed даёт одинаковый результат при любом числе потоков.
+ *
+ * @param out указатель на буфер.
+ * @param n число букв.
+ * @param seed начальное значение.
+ * @param threads число потоков, 0 — по числу ядер.
+ * @param offset позиция буфера в общей последовательности, кратная GEN_BLOCK.
+ */
+void fillRandomLetters(char* out, size_t n, uint64_t seed, unsigned threads, uint64_t offset = 0) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    size_t blocks = (n + GEN_BLOCK - 1) / GEN_BLOCK;
+    if (threads > blocks) threads = blocks > 0 ? unsigned(blocks) : 1;
+    uint64_t firstBlock = offset / GEN_BLOCK;
+
+    // Блоки раздаются потокам через один, чтобы нагрузка была равномерной.
+    auto worker = [&](unsigned t) {
+        for (size_t b = t; b < blocks; b += threads) {
+            size_t begin = b * GEN_BLOCK;
+            size_t len = n - begin < GEN_BLOCK ? n - begin : GEN_BLOCK;
+            fillLetterBlock(out + begin, len, seed, firstBlock + b);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+}
 
 /*
  * Генерирует случайную строку из строчных букв
  *
  * @param n длина строки.
+ * @param seed начальное значение генератора.
+ * @param threads число потоков, 0 — по числу ядер.
  * @return возвращает строку из случайных строчных букв.
  */
-std::string generateRandomString(int n) {
+std::string generateRandomString(long long n, uint64_t seed, unsigned threads = 1) {
     if (n < 0) { exit(1); }
-    std::string str(n, ' ');
-    for (int i = 0;i < n;i++) {
-        str[i] = 'a' + (rand() % 26);
-    }
+    std::string str(size_t(n), ' ');
+    fillRandomLetters(&str[0], str.size(), seed, threads);
     return str;
 }
 
+/*
+ * Записывает в файл случайные строчные буквы, генерируя их порциями,
+ * так что память не зависит от размера файла
+ *
+ * @param path путь к файлу.
+ * @param n число букв.
+ * @param seed начальное значение генератора.
+ * @param threads число потоков, 0 — по числу ядер.
+ * @return возвращает false, если запись не удалась.
+ */
+bool generateRandomFile(const char* path, unsigned long long n, uint64_t seed, unsigned threads) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        fprintf(stderr, "Не удалось создать файл: %s\n", path);
+        return false;
+    }
+    const size_t portion = GEN_BLOCK * 64;
+    std::string buffer(portion, ' ');
+    for (unsigned long long offset = 0; offset < n; offset += portion) {
+        size_t len = n - offset < portion ? size_t(n - offset) : portion;
+        fillRandomLetters(&buffer[0], len, seed, threads, offset);
+        out.write(buffer.data(), len);
+    }
+    return bool(out);
+}
+
 /*
  * Считывает и проверяет входную строку
  *
@@ -36,68 +290,1141 @@ std::string newString(std::string stroka = "") {
 }
 
 /*
- * Создает map частот символов в строке
+ * Создает гистограмму частот символов в строке
  *
  * @param str входная строка.
- * @return возвращает map, где ключи — символы, а значения — их частоты.
+ * @return возвращает гистограмму, где индекс — символ, а значение — его частота.
+ */
+LetterHistogram createMap(const std::string& str) {
+    LetterHistogram hist;
+    countBytes(hist, str.data(), str.size());
+    return hist;
+}
+
+/*
+ * Размер блока, которым файл читается в гистограмму.
+ * Память под чтение не зависит от размера файла.
+ */
+const size_t FILE_CHUNK = size_t(1) << 20;
+
+/*
+ * Проверяет, допустим ли байт во входном файле
+ *
+ * @param c проверяемый байт.
+ * @return true для строчной буквы или перевода строки.
  */
-std::map<char, int> createMap(std::string str) {
-    std::map<char, int> map;
-    for (char c : str) {
-        ++map[c];
+inline bool isValidFileByte(unsigned char c) {
+    return (unsigned char)(c - 'a') < 26 || c == '\n' || c == '\r';
+}
+
+/*
+ * Ищет первый байт, не прошедший проверку newString
+ *
+ * @param data указатель на блок.
+ * @param n размер блока.
+ * @return возвращает индекс первого недопустимого байта или n, если блок корректен.
+ */
+size_t findInvalidByte(const char* data, size_t n) {
+    const unsigned char* p = (const unsigned char*)data;
+    size_t i = 0;
+    // Проверка по 64 байта без раннего выхода, чтобы компилятор мог её векторизовать.
+    for (; i + 64 <= n; i += 64) {
+        bool bad = false;
+        for (int k = 0; k < 64; ++k) bad |= !isValidFileByte(p[i + k]);
+        if (bad) break;
     }
-    return map;
+    for (; i < n; ++i) {
+        if (!isValidFileByte(p[i])) return i;
+    }
+    return n;
 }
 
 /*
- * Выводит частоту каждого символа
+ * Читает файл блоками по FILE_CHUNK байт и передаёт каждый блок обработчику.
+ * По умолчанию каждый блок проверяется так же, как newString: допустимы
+ * только a–z и переводы строк.
  *
- * @param map словарь с частотами символов.
+ * @param path путь к файлу.
+ * @param onChunk обработчик, вызываемый как onChunk(data, size); false прерывает чтение.
+ * @param validate проверять ли содержимое блоков.
+ * @return возвращает false, если файл не открылся или содержит недопустимый символ.
  */
-void countLetters(std::map<char, int> map) {
-    for (auto item : map) {
-        printf("Символ: %c = %i\n", item.first, item.second);
+template <class ChunkHandler>
+bool readFileChunks(const char* path, ChunkHandler onChunk, bool validate = true) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "Не удалось открыть файл: %s\n", path);
+        return false;
+    }
+    std::string chunk(FILE_CHUNK, '\0');
+    uint64_t offset = 0;
+    while (file) {
+        file.read(&chunk[0], FILE_CHUNK);
+        size_t got = size_t(file.gcount());
+        if (got == 0) break;
+        size_t bad = validate ? findInvalidByte(chunk.data(), got) : got;
+        if (bad != got) {
+            fprintf(stderr, "Недопустимый символ в позиции %llu\n", (unsigned long long)(offset + bad));
+            return false;
+        }
+        if (!onChunk(chunk.data(), got)) return false;
+        offset += got;
     }
+    return true;
 }
 
 /*
- * Находит максимальную частоту символа
+ * Считает частоты символов в файле, читая его блоками по FILE_CHUNK байт.
+ * Переводы строк в гистограмму не попадают.
  *
- * @param map словарь с частотами символов.
- * @return возвращает максимальное значение частоты.
+ * @param path путь к файлу.
+ * @param hist гистограмма, в которую добавляются частоты.
+ * @return возвращает false, если файл не открылся или содержит недопустимый символ.
  */
-int findMostFrequent(std::map<char, int> map) {
-    int max = 0;
-    for (auto item : map) {
-        if (item.second > max) { max = item.second; }
+bool countFile(const char* path, LetterHistogram& hist) {
+    LetterHistogram local;
+    bool ok = readFileChunks(path, [&](const char* data, size_t n) { countBytes(local, data, n); return true; });
+    if (!ok) return false;
+    local.counts['\n'] = local.counts['\r'] = 0;
+    for (int c = 0; c < 256; ++c) hist.counts[c] += local.counts[c];
+    return true;
+}
+
+/*
+ * Файл, отображённый в память только для чтения.
+ * Страницы подгружаются системой по мере обращения, копия в куче не создаётся.
+ */
+class MappedFile {
+    const char* ptr = nullptr;
+    size_t len = 0;
+    bool opened = false;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+public:
+    /*
+     * Отображает файл в память
+     *
+     * @param path путь к файлу.
+     */
+    explicit MappedFile(const char* path) {
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) return;
+        if (size.QuadPart == 0) { opened = true; return; }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping) return;
+        ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (ptr) { len = size_t(size.QuadPart); opened = true; }
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { close(fd); return; }
+        if (st.st_size == 0) opened = true;
+        else {
+            void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, size_t(st.st_size), MADV_SEQUENTIAL);
+                ptr = (const char*)p;
+                len = size_t(st.st_size);
+                opened = true;
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (ptr) UnmapViewOfFile(ptr);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (ptr) munmap((void*)ptr, len);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /* Открылся ли файл (пустой файл открывается без отображения). */
+    bool isOpen() const { return opened; }
+    /* Указатель на начало данных или nullptr для пустого файла. */
+    const char* data() const { return ptr; }
+    /* Размер файла в байтах. */
+    size_t size() const { return len; }
+};
+
+/*
+ * Гистограмма отдельного потока, выровненная по строке кэша,
+ * чтобы счётчики соседних потоков не делили одну строку.
+ */
+struct alignas(64) ThreadHistogram {
+    LetterHistogram hist;
+};
+
+/*
+ * Границы части t при делении n байтов на parts частей.
+ * Длина части — n / parts с округлением вверх до кратной align, последняя
+ * часть всегда заканчивается на n, так что части покрывают весь буфер.
+ *
+ * @param n размер данных.
+ * @param parts число частей.
+ * @param align кратность длины части.
+ * @param t номер части.
+ * @param begin начало части.
+ * @param end конец части.
+ */
+void sliceBounds(size_t n, unsigned parts, size_t align, unsigned t, size_t& begin, size_t& end) {
+    size_t slice = (n + parts - 1) / parts;
+    slice = (slice + align - 1) / align * align;
+    begin = std::min(n, size_t(t) * slice);
+    end = t + 1 == parts ? n : std::min(n, begin + slice);
+}
+
+/*
+ * Считает частоты символов в буфере несколькими потоками.
+ * Буфер делится на равные части, каждый поток считает свою часть в собственную
+ * гистограмму, затем гистограммы складываются.
+ *
+ * @param hist гистограмма, в которую добавляются частоты.
+ * @param data указатель на данные.
+ * @param n размер данных в байтах.
+ * @param threads число потоков, 0 — по числу ядер.
+ * @param validate проверять ли блоки так же, как newString.
+ * @return возвращает смещение первого недопустимого байта или n, если всё корректно.
+ */
+size_t countParallel(LetterHistogram& hist, const char* data, size_t n, unsigned threads, bool validate) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    // Слишком мелкие части не окупают запуск потока.
+    size_t maxThreads = n / FILE_CHUNK + 1;
+    if (threads > maxThreads) threads = unsigned(maxThreads);
+
+    std::vector<ThreadHistogram> local(threads);
+    std::vector<size_t> badOffset(threads, n);
+
+    auto worker = [&](unsigned t) {
+        // Границы частей кратны 64 байтам, чтобы потоки не читали общие строки кэша.
+        size_t begin, end;
+        sliceBounds(n, threads, 64, t, begin, end);
+        for (size_t pos = begin; pos < end; pos += FILE_CHUNK) {
+            size_t len = end - pos < FILE_CHUNK ? end - pos : FILE_CHUNK;
+            if (validate) {
+                size_t bad = findInvalidByte(data + pos, len);
+                if (bad != len) { badOffset[t] = pos + bad; return; }
+            }
+            countBytes(local[t].hist, data + pos, len);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        size_t begin, end;
+        sliceBounds(n, threads, 64, t, begin, end);
+        if (begin < end) pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    for (unsigned t = 0; t < threads; ++t) {
+        if (badOffset[t] != n) return badOffset[t];
+    }
+    for (unsigned t = 0; t < threads; ++t) {
+        for (int c = 0; c < 256; ++c) hist.counts[c] += local[t].hist.counts[c];
     }
-    return max;
+    return n;
 }
 
 /*
- * Выводит гистограмму частот символов
+ * Создает гистограмму частот символов в строке несколькими потоками
  *
- * @param map словарь с частотами символов.
+ * @param str входная строка.
+ * @param threads число потоков, 0 — по числу ядер.
+ * @return возвращает гистограмму частот символов.
  */
-void printHistogram(std::map<char, int> map) {
-    for (auto items : map) {
-        std::cout << std::string(items.second, '*') << '\n';
+LetterHistogram createMapParallel(const std::string& str, unsigned threads) {
+    LetterHistogram hist;
+    countParallel(hist, str.data(), str.size(), threads, false);
+    return hist;
+}
+
+/*
+ * Считает частоты символов в файле, отображённом в память, несколькими потоками
+ *
+ * @param path путь к файлу.
+ * @param hist гистограмма, в которую добавляются частоты.
+ * @param threads число потоков, 0 — по числу ядер.
+ * @return возвращает false, если файл не открылся или содержит недопустимый символ.
+ */
+bool countFileParallel(const char* path, LetterHistogram& hist, unsigned threads) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        fprintf(stderr, "Не удалось отобразить файл: %s\n", path);
+        return false;
+    }
+    if (file.size() == 0) return true;
+    LetterHistogram local;
+    size_t bad = countParallel(local, file.data(), file.size(), threads, true);
+    if (bad != file.size()) {
+        fprintf(stderr, "Недопустимый символ в позиции %llu\n", (unsigned long long)bad);
+        return false;
     }
+    local.counts['\n'] = local.counts['\r'] = 0;
+    for (int c = 0; c < 256; ++c) hist.counts[c] += local.counts[c];
+    return true;
 }
 
-int main() {
-    setlocale(LC_ALL, "RUS");
-    srand(time(NULL));
+/*
+ * Итоги подсчёта, собранные за один проход по гистограмме.
+ */
+struct LetterStats {
+    LetterHistogram hist;
+    uint64_t max = 0;
+    int argmax = -1;
+    uint64_t total = 0;
+    double entropy = 0;
+};
+
+/*
+ * Вычисляет максимум, самый частый символ, общее число символов
+ * и энтропию Шеннона за один проход
+ *
+ * @param hist гистограмма частот символов.
+ * @return возвращает собранную статистику.
+ */
+LetterStats createStats(const LetterHistogram& hist) {
+    LetterStats stats;
+    stats.hist = hist;
+    double sumNLogN = 0;
+    for (int c = 0; c < 256; ++c) {
+        uint64_t n = hist.counts[c];
+        if (n == 0) continue;
+        if (n > stats.max) { stats.max = n; stats.argmax = c; }
+        stats.total += n;
+        sumNLogN += double(n) * std::log2(double(n));
+    }
+    // H = -sum(p * log2 p) = log2(total) - sum(n * log2 n) / total
+    if (stats.total > 0) stats.entropy = std::log2(double(stats.total)) - sumNLogN / double(stats.total);
+    return stats;
+}
+
+/*
+ * Ширина самого длинного столбца гистограммы. Если максимум меньше,
+ * столбцы рисуются без масштабирования, по одной звёздочке на символ.
+ */
+const size_t BAR_WIDTH = 60;
+
+/*
+ * Дописывает в буфер столбец гистограммы, отмасштабированный к BAR_WIDTH
+ *
+ * @param out буфер вывода.
+ * @param count частота.
+ * @param max максимальная частота.
+ */
+void appendBar(std::string& out, uint64_t count, uint64_t max) {
+    size_t len = size_t(count);
+    if (max > BAR_WIDTH) {
+        len = size_t(double(count) / double(max) * BAR_WIDTH + 0.5);
+        if (len == 0 && count > 0) len = 1;
+    }
+    out.append(len, '*');
+    out += '\n';
+}
+
+/*
+ * Дописывает в буфер частоту каждого встреченного символа
+ *
+ * @param stats статистика по символам.
+ * @param out буфер вывода.
+ */
+void countLetters(const LetterStats& stats, std::string& out) {
+    char line[64];
+    for (int c = 0; c < 256; ++c) {
+        if (stats.hist.counts[c] == 0) continue;
+        int len = snprintf(line, sizeof(line), "Символ: %c = %llu\n", c, (unsigned long long)stats.hist.counts[c]);
+        out.append(line, size_t(len));
+    }
+}
+
+/*
+ * Дописывает в буфер гистограмму частот символов
+ *
+ * @param stats статистика по символам.
+ * @param out буфер вывода.
+ */
+void printHistogram(const LetterStats& stats, std::string& out) {
+    for (int c = 0; c < 256; ++c) {
+        if (stats.hist.counts[c] == 0) continue;
+        appendBar(out, stats.hist.counts[c], stats.max);
+    }
+}
+
+/*
+ * Формирует полный отчёт в буфере и выводит его одной записью
+ *
+ * @param stats статистика по символам.
+ * @param out буфер вывода, переиспользуется между вызовами.
+ */
+void printReport(const LetterStats& stats, std::string& out) {
+    out.clear();
+    countLetters(stats, out);
+    char line[128];
+    int len = snprintf(line, sizeof(line), "макс:%llu\n", (unsigned long long)stats.max);
+    out.append(line, size_t(len));
+    if (stats.argmax >= 0) {
+        len = snprintf(line, sizeof(line), "Чаще всего: %c | всего: %llu | энтропия: %.4f бит\n",
+            stats.argmax, (unsigned long long)stats.total, stats.entropy);
+        out.append(line, size_t(len));
+    }
+    printHistogram(stats, out);
+    fwrite(out.data(), 1, out.size(), stdout);
+    fflush(stdout);
+}
+
+/*
+ * Частоты n-грамм над алфавитом a–z в плотном массиве из 26^n счётчиков.
+ * Индекс n-граммы — её запись в системе счисления с основанием 26.
+ * Окно последних букв хранится в структуре, поэтому данные можно подавать частями.
+ */
+struct NGramHistogram {
+    int order;
+    std::vector<uint64_t> counts;
+    uint32_t window = 0;
+    int filled = 0;
+
+    /*
+     * @param n длина n-граммы (2 или 3).
+     */
+    explicit NGramHistogram(int n) : order(n), counts(n == 2 ? 26 * 26 : 26 * 26 * 26, 0) {}
+};
+
+/*
+ * Однопроходный подсчёт n-грамм фиксированной длины N.
+ * Любой байт вне a–z (например, перевод строки) обрывает окно.
+ * Внутри серии букв индекс каждой n-граммы считается прямо из соседних байтов,
+ * без зависимости между итерациями; окно нужно только на стыке блоков.
+ */
+template <int N>
+void countNGramsN(NGramHistogram& hist, const unsigned char* p, size_t n) {
+    const uint32_t prefixSize = N == 2 ? 26 : 26 * 26;
+    uint64_t* counts = hist.counts.data();
+    size_t i = 0;
+    while (i < n) {
+        // Первые N-1 букв серии могут продолжать n-грамму из предыдущего блока.
+        size_t k = i;
+        size_t head = n - i < N - 1 ? n : i + N - 1;
+        for (; k < head; ++k) {
+            uint32_t c = uint32_t(p[k]) - 'a';
+            if (c >= 26) break;
+            hist.window = (hist.window % prefixSize) * 26 + c;
+            if (hist.filled < N) ++hist.filled;
+            if (hist.filled == N) ++counts[hist.window];
+        }
+        if (k == head) {
+            for (; k < n; ++k) {
+                if (uint32_t(p[k]) - 'a' >= 26) break;
+                uint32_t index = 0;
+                for (int d = N - 1; d >= 0; --d) index = index * 26 + (p[k - d] - 'a');
+                ++counts[index];
+            }
+        }
+        size_t end = k;
+        if (end - i >= N - 1) {
+            hist.window = 0;
+            for (size_t j = end - (N - 1); j < end; ++j) hist.window = hist.window * 26 + (p[j] - 'a');
+            hist.filled = N - 1;
+        }
+
+        if (end < n) {
+            hist.window = 0;
+            hist.filled = 0;
+        }
+        i = end + 1;
+    }
+}
+
+/*
+ * Добавляет в гистограмму n-граммы из буфера
+ *
+ * @param hist гистограмма n-грамм.
+ * @param data указатель на данные.
+ * @param n размер данных в байтах.
+ */
+void countNGrams(NGramHistogram& hist, const char* data, size_t n) {
+    if (hist.order == 2) countNGramsN<2>(hist, (const unsigned char*)data, n);
+    else countNGramsN<3>(hist, (const unsigned char*)data, n);
+}
+
+/*
+ * Создает гистограмму n-грамм строки
+ *
+ * @param str входная строка.
+ * @param order длина n-граммы (2 или 3).
+ * @return возвращает гистограмму n-грамм.
+ */
+NGramHistogram createNGramMap(const std::string& str, int order) {
+    NGramHistogram hist(order);
+    countNGrams(hist, str.data(), str.size());
+    return hist;
+}
+
+/*
+ * Восстанавливает текст n-граммы по её индексу
+ *
+ * @param index индекс в массиве счётчиков.
+ * @param order длина n-граммы.
+ * @return возвращает n-грамму в виде строки.
+ */
+std::string ngramName(uint32_t index, int order) {
+    std::string name(order, 'a');
+    for (int i = order - 1; i >= 0; --i) {
+        name[i] = char('a' + index % 26);
+        index /= 26;
+    }
+    return name;
+}
+
+/*
+ * Находит K самых частых n-грамм
+ *
+ * @param hist гистограмма n-грамм.
+ * @param k число n-грамм в ответе.
+ * @return возвращает индексы n-грамм по убыванию частоты (нулевые не включаются).
+ */
+std::vector<uint32_t> findTopNGrams(const NGramHistogram& hist, size_t k) {
+    std::vector<uint32_t> index;
+    for (uint32_t i = 0; i < hist.counts.size(); ++i) {
+        if (hist.counts[i] != 0) index.push_back(i);
+    }
+    if (k > index.size()) k = index.size();
+    std::partial_sort(index.begin(), index.begin() + k, index.end(), [&](uint32_t a, uint32_t b) {
+        return hist.counts[a] != hist.counts[b] ? hist.counts[a] > hist.counts[b] : a < b;
+    });
+    index.resize(k);
+    return index;
+}
+
+/*
+ * Выводит K самых частых n-грамм и их гистограмму
+ *
+ * @param hist гистограмма n-грамм.
+ * @param k число выводимых n-грамм.
+ */
+void printNGramHistogram(const NGramHistogram& hist, size_t k) {
+    std::vector<uint32_t> top = findTopNGrams(hist, k);
+    std::string out;
+    char line[64];
+    for (uint32_t i : top) {
+        int len = snprintf(line, sizeof(line), "N-грамма: %s = %llu\n",
+            ngramName(i, hist.order).c_str(), (unsigned long long)hist.counts[i]);
+        out.append(line, size_t(len));
+    }
+    uint64_t max = top.empty() ? 0 : hist.counts[top[0]];
+    for (uint32_t i : top) {
+        out += ngramName(i, hist.order);
+        out += ' ';
+        appendBar(out, hist.counts[i], max);
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+}
+
+/*
+ * Гистограмма последних W символов потока.
+ * Кроме частот хранится, сколько символов имеют каждую частоту, поэтому
+ * максимум обновляется за O(1) при добавлении и вытеснении символа.
+ */
+class SlidingHistogram {
+    std::vector<unsigned char> ring;
+    size_t head = 0;
+    size_t filled = 0;
+    uint32_t counts[256] = {};
+    std::vector<uint32_t> withCount;
+    uint32_t maxCount = 0;
+
+    /* Увеличивает частоту символа на 1 */
+    void increment(unsigned char c) {
+        --withCount[counts[c]];
+        ++withCount[++counts[c]];
+        if (counts[c] > maxCount) maxCount = counts[c];
+    }
+
+    /* Уменьшает частоту символа на 1 */
+    void decrement(unsigned char c) {
+        // Если символ был единственным с максимальной частотой, максимум
+        // становится на единицу меньше — это его новая частота.
+        if (counts[c] == maxCount && withCount[maxCount] == 1) --maxCount;
+        --withCount[counts[c]];
+        ++withCount[--counts[c]];
+    }
+
+public:
+    /*
+     * Конструктор окна.
+     * @param window размер окна W (не меньше 1).
+     */
+    explicit SlidingHistogram(size_t window)
+        : ring(window > 0 ? window : 1), withCount(ring.size() + 1, 0) {
+        withCount[0] = 256;
+    }
+
+    /*
+     * Добавляет символ в окно; самый старый символ вытесняется, если окно заполнено.
+     * @param c новый символ.
+     */
+    void push(char c) {
+        unsigned char u = (unsigned char)c;
+        if (filled == ring.size()) decrement(ring[head]);
+        else ++filled;
+        ring[head] = u;
+        if (++head == ring.size()) head = 0;
+        increment(u);
+    }
+
+    /*
+     * Возвращает частоту символа в текущем окне.
+     * @param c символ.
+     */
+    uint32_t count(char c) const { return counts[(unsigned char)c]; }
+
+    /*
+     * Возвращает максимальную частоту символа в текущем окне.
+     */
+    uint32_t findMostFrequent() const { return maxCount; }
+
+    /*
+     * Возвращает число символов в окне.
+     */
+    size_t size() const { return filled; }
+};
+
+/*
+ * Счётчик слова в приближённом подсчёте.
+ * Истинная частота лежит в пределах [count - error, count].
+ */
+struct TokenCounter {
+    std::string token;
+    uint64_t count = 0;
+    uint64_t error = 0;
+    size_t heapPos = 0;
+};
+
+/*
+ * Приближённый подсчёт самых частых слов алгоритмом Space-Saving.
+ * Хранится не больше capacity счётчиков, поэтому память не зависит от числа
+ * различных слов. Любое слово с частотой больше total / capacity гарантированно
+ * остаётся в таблице, а ошибка каждого счётчика не превышает total / capacity.
+ */
+class SpaceSaving {
+    size_t capacity;
+    std::vector<TokenCounter> counters;
+    std::vector<size_t> heap;
+    std::unordered_map<std::string, size_t> where;
+    std::string key;
+    uint64_t total = 0;
+
+    /* Меняет местами два элемента кучи */
+    void swapHeap(size_t a, size_t b) {
+        std::swap(heap[a], heap[b]);
+        counters[heap[a]].heapPos = a;
+        counters[heap[b]].heapPos = b;
+    }
+
+    /* Просеивает элемент вниз после увеличения его счётчика */
+    void siftDown(size_t pos) {
+        for (;;) {
+            size_t smallest = pos, l = 2 * pos + 1, r = l + 1;
+            if (l < heap.size() && counters[heap[l]].count < counters[heap[smallest]].count) smallest = l;
+            if (r < heap.size() && counters[heap[r]].count < counters[heap[smallest]].count) smallest = r;
+            if (smallest == pos) return;
+            swapHeap(pos, smallest);
+            pos = smallest;
+        }
+    }
+
+    /* Поднимает только что добавленный элемент вверх */
+    void siftUp(size_t pos) {
+        while (pos > 0) {
+            size_t parent = (pos - 1) / 2;
+            if (counters[heap[parent]].count <= counters[heap[pos]].count) return;
+            swapHeap(pos, parent);
+            pos = parent;
+        }
+    }
+
+public:
+    /*
+     * Конструктор.
+     * @param epsilon допустимая ошибка как доля от общего числа слов (0 < epsilon < 1).
+     */
+    explicit SpaceSaving(double epsilon)
+        : capacity(size_t(std::ceil(1.0 / (epsilon > 0 && epsilon < 1 ? epsilon : 0.001)))) {
+        counters.reserve(capacity);
+        heap.reserve(capacity);
+        where.reserve(capacity);
+    }
+
+    /*
+     * Учитывает одно вхождение слова.
+     * @param data указатель на начало слова.
+     * @param n длина слова.
+     */
+    void add(const char* data, size_t n) {
+        ++total;
+        key.assign(data, n);
+        auto it = where.find(key);
+        if (it != where.end()) {
+            ++counters[it->second].count;
+            siftDown(counters[it->second].heapPos);
+            return;
+        }
+        if (counters.size() < capacity) {
+            size_t idx = counters.size();
+            counters.push_back(TokenCounter{ key, 1, 0, heap.size() });
+            heap.push_back(idx);
+            where.emplace(key, idx);
+            siftUp(heap.size() - 1);
+            return;
+        }
+        // Вытесняем слово с наименьшим счётчиком: новое наследует его значение как ошибку.
+        size_t idx = heap[0];
+        TokenCounter& victim = counters[idx];
+        where.erase(victim.token);
+        victim.token = key;
+        victim.error = victim.count;
+        ++victim.count;
+        where.emplace(key, idx);
+        siftDown(0);
+    }
+
+    /*
+     * Возвращает K слов с наибольшими счётчиками по убыванию.
+     * @param k число слов.
+     */
+    std::vector<TokenCounter> top(size_t k) const {
+        std::vector<TokenCounter> result(counters);
+        if (k > result.size()) k = result.size();
+        std::partial_sort(result.begin(), result.begin() + k, result.end(),
+            [](const TokenCounter& a, const TokenCounter& b) { return a.count > b.count; });
+        result.resize(k);
+        return result;
+    }
+
+    /* Общее число учтённых слов. */
+    uint64_t size() const { return total; }
+
+    /* Верхняя граница ошибки любого счётчика: total / capacity. */
+    uint64_t errorBound() const { return total / capacity; }
+};
+
+/*
+ * Разбивает блок на слова (разделители — пробелы и управляющие символы)
+ * и добавляет их в счётчик. Слово, оборванное концом блока, сохраняется в carry.
+ *
+ * @param sketch счётчик слов.
+ * @param data указатель на блок.
+ * @param n размер блока.
+ * @param carry начало слова из предыдущего блока.
+ */
+void countTokens(SpaceSaving& sketch, const char* data, size_t n, std::string& carry) {
+    size_t i = 0;
+    while (i < n) {
+        size_t begin = i;
+        while (i < n && (unsigned char)data[i] > ' ') ++i;
+        if (i == n) {
+            carry.append(data + begin, n - begin);
+            return;
+        }
+        if (!carry.empty()) {
+            carry.append(data + begin, i - begin);
+            sketch.add(carry.data(), carry.size());
+            carry.clear();
+        }
+        else if (i > begin) {
+            sketch.add(data + begin, i - begin);
+        }
+        ++i;
+    }
+}
+
+/*
+ * Считает слова в файле приближённо, с фиксированной памятью
+ *
+ * @param path путь к файлу.
+ * @param sketch счётчик, в который добавляются слова.
+ * @return возвращает false, если файл не открылся.
+ */
+bool countFileTokens(const char* path, SpaceSaving& sketch) {
+    std::string carry;
+    bool ok = readFileChunks(path, [&](const char* data, size_t n) { countTokens(sketch, data, n, carry); return true; }, false);
+    if (!carry.empty()) sketch.add(carry.data(), carry.size());
+    return ok;
+}
+
+/*
+ * Находит K самых частых слов
+ *
+ * @param sketch счётчик слов.
+ * @param k число слов в ответе.
+ * @return возвращает слова по убыванию частоты с оценкой ошибки.
+ */
+std::vector<TokenCounter> findMostFrequentTokens(const SpaceSaving& sketch, size_t k) {
+    return sketch.top(k);
+}
+
+/*
+ * Выводит K самых частых слов с границами их частот
+ *
+ * @param sketch счётчик слов.
+ * @param k число слов.
+ */
+void printTokens(const SpaceSaving& sketch, size_t k) {
+    std::string out;
+    char line[128];
+    int len = snprintf(line, sizeof(line), "Всего слов: %llu | ошибка не больше: %llu\n",
+        (unsigned long long)sketch.size(), (unsigned long long)sketch.errorBound());
+    out.append(line, size_t(len));
+    for (const TokenCounter& t : findMostFrequentTokens(sketch, k)) {
+        out += "Слово: ";
+        out += t.token;
+        len = snprintf(line, sizeof(line), " = %llu (от %llu)\n",
+            (unsigned long long)t.count, (unsigned long long)(t.count - t.error));
+        out.append(line, size_t(len));
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+}
+
+/*
+ * Частоты кодовых точек для текста в UTF-8.
+ * ASCII (U+0000–U+007F) и кириллица (U+0400–U+04FF) хранятся в плоских
+ * таблицах, все прочие кодовые точки учитываются одним счётчиком.
+ */
+struct CodepointHistogram {
+    uint64_t ascii[128] = {};
+    uint64_t cyrillic[256] = {};
+    uint64_t other = 0;
+};
+
+/*
+ * Проверяет, что 16 байт — только ASCII
+ */
+inline bool isAsciiBlock16(const unsigned char* p) {
+#if defined(__SSE2__) || defined(_M_X64)
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p)) == 0;
+#elif defined(__aarch64__)
+    return vmaxvq_u8(vld1q_u8(p)) < 0x80;
+#else
+    uint64_t a, b;
+    memcpy(&a, p, 8);
+    memcpy(&b, p + 8, 8);
+    return ((a | b) & 0x8080808080808080ull) == 0;
+#endif
+}
+
+/*
+ * Проверяет, что 16 байт — восемь двухбайтовых символов кириллицы:
+ * на чётных местах ведущие байты D0–D3, на нечётных — байты продолжения 80–BF.
+ */
+inline bool isCyrillicBlock16(const unsigned char* p) {
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i mask = _mm_set1_epi16(short(0xC0FC));
+    const __m128i want = _mm_set1_epi16(short(0x80D0));
+    __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i*)p), mask);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, want)) == 0xFFFF;
+#elif defined(__aarch64__)
+    const uint8x16_t mask = vreinterpretq_u8_u16(vdupq_n_u16(0xC0FC));
+    const uint8x16_t want = vreinterpretq_u8_u16(vdupq_n_u16(0x80D0));
+    return vminvq_u8(vceqq_u8(vandq_u8(vld1q_u8(p), mask), want)) == 0xFF;
+#else
+    uint64_t a, b;
+    memcpy(&a, p, 8);
+    memcpy(&b, p + 8, 8);
+    const uint64_t mask = 0xC0FCC0FCC0FCC0FCull, want = 0x80D080D080D080D0ull;
+    return (a & mask) == want && (b & mask) == want;
+#endif
+}
+
+/*
+ * Декодирует одну кодовую точку UTF-8 с полной проверкой
+ * (лишние байты продолжения, избыточная запись, суррогаты, выход за U+10FFFF)
+ *
+ * @param p указатель на первый байт.
+ * @param avail сколько байт доступно.
+ * @param cp декодированная кодовая точка.
+ * @return возвращает длину последовательности, 0 — если байтов не хватает, -1 — при ошибке.
+ */
+int decodeUtf8(const unsigned char* p, size_t avail, uint32_t& cp) {
+    unsigned char b = p[0];
     int len;
-    std::cout << "Введите размер: ";
-    std::cin >> len;
-    std::string stroka;
-    stroka = generateRandomString(len);
-
-    std::cout << "\nСтрока: " << stroka << std::endl;
-    std::map<char, int> mapString = createMap(stroka);
-    countLetters(mapString);
-    std::cout << "макс:" << findMostFrequent(mapString) << '\n';
-    printHistogram(mapString);
+    uint32_t min;
+    if (b < 0x80) { cp = b; return 1; }
+    else if (b >= 0xC2 && b <= 0xDF) { len = 2; cp = b & 0x1F; min = 0x80; }
+    else if (b >= 0xE0 && b <= 0xEF) { len = 3; cp = b & 0x0F; min = 0x800; }
+    else if (b >= 0xF0 && b <= 0xF4) { len = 4; cp = b & 0x07; min = 0x10000; }
+    else return -1;
+    for (int k = 1; k < len; ++k) {
+        if (size_t(k) >= avail) return 0;
+        if ((p[k] & 0xC0) != 0x80) return -1;
+        cp = (cp << 6) | (p[k] & 0x3F);
+    }
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return -1;
+    return len;
+}
+
+/*
+ * Добавляет кодовую точку в гистограмму
+ */
+inline void addCodepoint(CodepointHistogram& hist, uint32_t cp) {
+    if (cp < 0x80) ++hist.ascii[cp];
+    else if (cp - 0x400 < 0x100) ++hist.cyrillic[cp - 0x400];
+    else ++hist.other;
+}
+
+/*
+ * Потоковый подсчёт кодовых точек UTF-8. Последовательность, оборванная
+ * концом блока, дописывается из следующего блока.
+ */
+struct Utf8Counter {
+    CodepointHistogram hist;
+    unsigned char carry[4] = {};
+    size_t carryLen = 0;
+    uint64_t carryStart = 0;
+    uint64_t offset = 0;
+};
+
+/*
+ * Проверяет и считает очередной блок UTF-8.
+ * Серии ASCII и двухбайтовой кириллицы проверяются по 16 байт за раз.
+ *
+ * @param counter состояние подсчёта.
+ * @param data указатель на блок.
+ * @param n размер блока.
+ * @return возвращает false при некорректной последовательности.
+ */
+bool countUtf8(Utf8Counter& counter, const char* data, size_t n) {
+    const unsigned char* p = (const unsigned char*)data;
+    CodepointHistogram& hist = counter.hist;
+    size_t i = 0;
+    uint32_t cp;
+
+    // Дописываем последовательность, начатую в предыдущем блоке.
+    while (counter.carryLen > 0 && i < n) {
+        counter.carry[counter.carryLen++] = p[i++];
+        int len = decodeUtf8(counter.carry, counter.carryLen, cp);
+        if (len < 0) {
+            fprintf(stderr, "Некорректный UTF-8 в позиции %llu\n", (unsigned long long)counter.carryStart);
+            return false;
+        }
+        if (len > 0) {
+            addCodepoint(hist, cp);
+            counter.carryLen = 0;
+        }
+    }
+
+    while (i < n) {
+        while (i + 16 <= n && isAsciiBlock16(p + i)) {
+            for (int k = 0; k < 16; ++k) ++hist.ascii[p[i + k]];
+            i += 16;
+        }
+        while (i + 16 <= n && isCyrillicBlock16(p + i)) {
+            for (int k = 0; k < 16; k += 2) ++hist.cyrillic[((p[i + k] & 0x03) << 6) | (p[i + k + 1] & 0x3F)];
+            i += 16;
+        }
+        if (i >= n) break;
+        // Одиночные ASCII и кириллица в коротких словах, без общего декодера.
+        if (p[i] < 0x80) { ++hist.ascii[p[i]]; ++i; continue; }
+        if ((p[i] & 0xFC) == 0xD0 && i + 1 < n && (p[i + 1] & 0xC0) == 0x80) {
+            ++hist.cyrillic[((p[i] & 0x03) << 6) | (p[i + 1] & 0x3F)];
+            i += 2;
+            continue;
+        }
+        int len = decodeUtf8(p + i, n - i, cp);
+        if (len == 0) {
+            counter.carryLen = n - i;
+            counter.carryStart = counter.offset + i;
+            memcpy(counter.carry, p + i, counter.carryLen);
+            break;
+        }
+        if (len < 0) {
+            fprintf(stderr, "Некорректный UTF-8 в позиции %llu\n", (unsigned long long)(counter.offset + i));
+            return false;
+        }
+        addCodepoint(hist, cp);
+        i += size_t(len);
+    }
+    counter.offset += n;
+    return true;
+}
+
+/*
+ * Считает кодовые точки в файле UTF-8
+ *
+ * @param path путь к файлу.
+ * @param hist гистограмма, в которую добавляются частоты.
+ * @return возвращает false, если файл не открылся, содержит некорректный UTF-8
+ * или обрывается посреди последовательности.
+ */
+bool countUtf8File(const char* path, CodepointHistogram& hist) {
+    Utf8Counter counter;
+    bool ok = readFileChunks(path, [&](const char* data, size_t n) { return countUtf8(counter, data, n); }, false);
+    if (!ok) return false;
+    if (counter.carryLen > 0) {
+        fprintf(stderr, "Файл обрывается посреди символа в позиции %llu\n", (unsigned long long)counter.carryStart);
+        return false;
+    }
+    for (int c = 0; c < 128; ++c) hist.ascii[c] += counter.hist.ascii[c];
+    for (int c = 0; c < 256; ++c) hist.cyrillic[c] += counter.hist.cyrillic[c];
+    hist.other += counter.hist.other;
+    return true;
+}
+
+/*
+ * Дописывает в буфер кодовую точку в UTF-8 (только до U+07FF)
+ */
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) out += char(cp);
+    else {
+        out += char(0xC0 | (cp >> 6));
+        out += char(0x80 | (cp & 0x3F));
+    }
+}
+
+/*
+ * Выводит частоты латинских и кириллических букв и их гистограмму
+ *
+ * @param hist гистограмма кодовых точек.
+ */
+void printCodepoints(const CodepointHistogram& hist) {
+    std::vector<std::pair<uint32_t, uint64_t>> letters;
+    for (uint32_t c = 'A'; c <= 'z'; ++c) {
+        if ((c <= 'Z' || c >= 'a') && hist.ascii[c] != 0) letters.push_back({ c, hist.ascii[c] });
+    }
+    for (uint32_t c = 0x400; c < 0x500; ++c) {
+        bool letter = (c >= 0x410 && c <= 0x44F) || c == 0x401 || c == 0x451;
+        if (letter && hist.cyrillic[c - 0x400] != 0) letters.push_back({ c, hist.cyrillic[c - 0x400] });
+    }
+    uint64_t max = 0, total = hist.other;
+    for (auto& l : letters) max = l.second > max ? l.second : max;
+    for (int c = 0; c < 128; ++c) total += hist.ascii[c];
+    for (int c = 0; c < 256; ++c) total += hist.cyrillic[c];
+
+    std::string out;
+    char line[96];
+    for (auto& l : letters) {
+        out += "Символ: ";
+        appendUtf8(out, l.first);
+        int len = snprintf(line, sizeof(line), " = %llu\n", (unsigned long long)l.second);
+        out.append(line, size_t(len));
+    }
+    int len = snprintf(line, sizeof(line), "макс:%llu\nВсего кодовых точек: %llu\n",
+        (unsigned long long)max, (unsigned long long)total);
+    out.append(line, size_t(len));
+    for (auto& l : letters) {
+        appendUtf8(out, l.first);
+        out += ' ';
+        appendBar(out, l.second, max);
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+}
+
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "RUS");
+    LetterHistogram histogram;
+    if (argc > 1 && strcmp(argv[1], "--generate") == 0) {
+        // Генерация корпуса: laba1 --generate <путь> <размер> <seed> [потоков]
+        if (argc < 5) {
+            fprintf(stderr, "Использование: laba1 --generate <путь> <размер> <seed> [потоков]\n");
+            return 1;
+        }
+        unsigned threads = argc > 5 ? unsigned(atoi(argv[5])) : 0;
+        return generateRandomFile(argv[2], strtoull(argv[3], nullptr, 10),
+            strtoull(argv[4], nullptr, 10), threads) ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "--window") == 0) {
+        // Скользящее окно: laba1 --window <W> <путь> — "макс" после каждой буквы
+        if (argc < 4 || atoll(argv[2]) <= 0) {
+            fprintf(stderr, "Использование: laba1 --window <W> <путь>\n");
+            return 1;
+        }
+        SlidingHistogram window(size_t(atoll(argv[2])));
+        std::string out;
+        bool ok = readFileChunks(argv[3], [&](const char* data, size_t n) {
+            out.clear();
+            for (size_t i = 0; i < n; ++i) {
+                if (data[i] == '\n' || data[i] == '\r') continue;
+                window.push(data[i]);
+                out += std::to_string(window.findMostFrequent());
+                out += '\n';
+            }
+            fwrite(out.data(), 1, out.size(), stdout);
+            return true;
+        });
+        return ok ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "--utf8") == 0) {
+        // Подсчёт латиницы и кириллицы в UTF-8: laba1 --utf8 <путь>
+        if (argc < 3) {
+            fprintf(stderr, "Использование: laba1 --utf8 <путь>\n");
+            return 1;
+        }
+#ifdef _WIN32
+        SetConsoleOutputCP(CP_UTF8);
+#endif
+        CodepointHistogram codepoints;
+        if (!countUtf8File(argv[2], codepoints)) { exit(1); }
+        printCodepoints(codepoints);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--tokens") == 0) {
+        // Частые слова: laba1 --tokens <путь> [K] [epsilon]
+        if (argc < 3) {
+            fprintf(stderr, "Использование: laba1 --tokens <путь> [K] [epsilon]\n");
+            return 1;
+        }
+        size_t k = argc > 3 ? size_t(atoll(argv[3])) : 10;
+        SpaceSaving sketch(argc > 4 ? atof(argv[4]) : 0.001);
+        if (!countFileTokens(argv[2], sketch)) { exit(1); }
+        printTokens(sketch, k);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--ngram") == 0) {
+        // Частоты n-грамм в файле: laba1 --ngram <2|3> <путь> [K]
+        int order = argc > 2 ? atoi(argv[2]) : 0;
+        if (argc < 4 || (order != 2 && order != 3)) {
+            fprintf(stderr, "Использование: laba1 --ngram <2|3> <путь> [K]\n");
+            return 1;
+        }
+        size_t k = argc > 4 ? size_t(atoll(argv[4])) : 10;
+        NGramHistogram ngrams(order);
+        bool ok = readFileChunks(argv[3], [&](const char* data, size_t n) { countNGrams(ngrams, data, n); return true; });
+        if (!ok) { exit(1); }
+        printNGramHistogram(ngrams, k);
+        return 0;
+    }
+    if (argc > 1) {
+        // Режим файла: laba1 <путь> [потоков]. Без числа потоков файл читается
+        // блоками в одном потоке, с ним — отображается в память и делится между потоками.
+        bool ok = argc > 2
+            ? countFileParallel(argv[1], histogram, unsigned(atoi(argv[2])))
+            : countFile(argv[1], histogram);
+        if (!ok) { exit(1); }
+    }
+    else {
+        long long len;
+        std::cout << "Введите размер: ";
+        std::cin >> len;
+        std::string stroka;
+        stroka = generateRandomString(len, uint64_t(time(NULL)));
+
+        std::cout << "\nСтрока: " << stroka << std::endl;
+        histogram = createMap(stroka);
+    }
+    std::string report;
+    printReport(createStats(histogram), report);
     return 1;
 }
\ No newline at end of file
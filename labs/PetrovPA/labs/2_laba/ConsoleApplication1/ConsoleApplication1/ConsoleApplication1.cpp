@@ -1,113 +1,2222 @@
 ﻿#include <iostream>
 #include <ctime>
+#include <algorithm>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <xmmintrin.h>
+#endif
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
 /*
- * Сортировка массива (разбиение)
+ * Размер части, которая досортировывается вставками.
+ */
+const size_t INSERTION_SORT_THRESHOLD = 24;
+
+/*
+ * Начиная с этого размера опорный элемент выбирается медианой из трёх медиан (ninther).
+ */
+const size_t NINTHER_THRESHOLD = 128;
+
+/*
+ * Сколько сдвигов допускает частичная сортировка вставками, прежде чем сдаться.
+ */
+const size_t PARTIAL_INSERTION_LIMIT = 8;
+
+/*
+ * Сортировка вставками
+ *
+ * @param begin указатель на первый элемент.
+ * @param end указатель за последний элемент.
+ */
+template <class T>
+void insertionSort(T* begin, T* end) {
+    if (begin == end) return;
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T tmp = *cur;
+        T* sift = cur;
+        while (sift != begin && tmp < *(sift - 1)) {
+            *sift = *(sift - 1);
+            --sift;
+        }
+        *sift = tmp;
+    }
+}
+
+/*
+ * Сортировка вставками без проверки левой границы.
+ * Слева от begin обязан лежать элемент, не больший любого элемента части.
+ *
+ * @param begin указатель на первый элемент.
+ * @param end указатель за последний элемент.
+ */
+template <class T>
+void unguardedInsertionSort(T* begin, T* end) {
+    if (begin == end) return;
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T tmp = *cur;
+        T* sift = cur;
+        while (tmp < *(sift - 1)) {
+            *sift = *(sift - 1);
+            --sift;
+        }
+        *sift = tmp;
+    }
+}
+
+/*
+ * Сортировка вставками, которая сдаётся после PARTIAL_INSERTION_LIMIT сдвигов
+ *
+ * @param begin указатель на первый элемент.
+ * @param end указатель за последний элемент.
+ * @return возвращает true, если часть удалось досортировать.
+ */
+template <class T>
+bool partialInsertionSort(T* begin, T* end) {
+    if (begin == end) return true;
+    size_t moved = 0;
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        if (*cur < *(cur - 1)) {
+            T tmp = *cur;
+            T* sift = cur;
+            do {
+                *sift = *(sift - 1);
+                --sift;
+            } while (sift != begin && tmp < *(sift - 1));
+            *sift = tmp;
+            moved += size_t(cur - sift);
+        }
+        if (moved > PARTIAL_INSERTION_LIMIT) return false;
+    }
+    return true;
+}
+
+/*
+ * Упорядочивает три элемента по возрастанию
+ */
+template <class T>
+void sort3(T* a, T* b, T* c) {
+    if (*b < *a) swap(*a, *b);
+    if (*c < *b) swap(*b, *c);
+    if (*b < *a) swap(*a, *b);
+}
+
+/*
+ * Выбирает опорный элемент (медиана из трёх или ninther) и ставит его в begin.
+ * После выбора в конце части лежит элемент не меньше опорного.
+ *
+ * @param begin указатель на первый элемент.
+ * @param end указатель за последний элемент (размер части не меньше 3).
+ */
+template <class T>
+void choosePivot(T* begin, T* end) {
+    size_t size = size_t(end - begin);
+    size_t half = size / 2;
+    if (size > NINTHER_THRESHOLD) {
+        sort3(begin, begin + half, end - 1);
+        sort3(begin + 1, begin + (half - 1), end - 2);
+        sort3(begin + 2, begin + (half + 1), end - 3);
+        sort3(begin + (half - 1), begin + half, begin + (half + 1));
+        swap(*begin, *(begin + half));
+    }
+    else {
+        sort3(begin + half, begin, end - 1);
+    }
+}
+
+/*
+ * Пирамидальная сортировка — запасной вариант с гарантированным O(n log n)
+ *
+ * @param begin указатель на первый элемент.
+ * @param end указатель за последний элемент.
+ */
+template <class T>
+void heapSortArr(T* begin, T* end) {
+    make_heap(begin, end);
+    sort_heap(begin, end);
+}
+
+/*
+ * Разбиение массива относительно опорного элемента *begin.
+ * Элементы, равные опорному, уходят вправо.
+ *
+ * @param begin указатель на первый элемент (опорный).
+ * @param end указатель за последний элемент.
+ * @param alreadyPartitioned true, если массив уже был разбит и обменов не понадобилось.
+ * @return возвращает указатель на опорный элемент после разбиения.
+ */
+template <class T>
+T* partitionRight(T* begin, T* end, bool& alreadyPartitioned) {
+    T pivot = *begin;
+    T* first = begin;
+    T* last = end;
+
+    // Справа от опорного есть элемент не меньше его (медиана из трёх), слева — сам опорный,
+    // поэтому внутренние циклы не выходят за границы.
+    while (*++first < pivot);
+    if (first - 1 == begin) {
+        while (first < last && !(*--last < pivot));
+    }
+    else {
+        while (!(*--last < pivot));
+    }
+
+    alreadyPartitioned = first >= last;
+    while (first < last) {
+        swap(*first, *last);
+        while (*++first < pivot);
+        while (!(*--last < pivot));
+    }
+
+    T* pivotPos = first - 1;
+    *begin = *pivotPos;
+    *pivotPos = pivot;
+    return pivotPos;
+}
+
+/*
+ * Разбиение, при котором элементы, равные опорному, уходят влево.
+ * Применяется, когда опорный равен элементу слева от части: тогда все
+ * равные ему уже на своих местах и повторно их сортировать не нужно.
+ *
+ * @param begin указатель на первый элемент (опорный).
+ * @param end указатель за последний элемент.
+ * @return возвращает указатель на опорный элемент после разбиения.
+ */
+template <class T>
+T* partitionLeft(T* begin, T* end) {
+    T pivot = *begin;
+    T* first = begin;
+    T* last = end;
+
+    while (pivot < *--last);
+    if (last + 1 == end) {
+        while (first < last && !(pivot < *++first));
+    }
+    else {
+        while (!(pivot < *++first));
+    }
+
+    while (first < last) {
+        swap(*first, *last);
+        while (pivot < *--last);
+        while (!(pivot < *++first));
+    }
+
+    T* pivotPos = last;
+    *begin = *pivotPos;
+    *pivotPos = pivot;
+    return pivotPos;
+}
+
+/*
+ * Основной цикл сортировки с защитой от вырождения (pattern-defeating quicksort).
+ * Рекурсия идёт в меньшую часть, поэтому глубина стека O(log n).
+ *
+ * @param begin указатель на первый элемент.
+ * @param end указатель за последний элемент.
+ * @param badAllowed сколько ещё неудачных разбиений допускается до перехода на heapsort.
+ * @param leftmost true, если слева от части нет элементов массива.
+ */
+template <class T>
+void sortLoop(T* begin, T* end, int badAllowed, bool leftmost) {
+    while (true) {
+        size_t size = size_t(end - begin);
+        if (size < INSERTION_SORT_THRESHOLD) {
+            if (leftmost) insertionSort(begin, end);
+            else unguardedInsertionSort(begin, end);
+            return;
+        }
+
+        choosePivot(begin, end);
+
+        // Опорный равен элементу слева — вся группа равных уже на месте.
+        if (!leftmost && !(*(begin - 1) < *begin)) {
+            begin = partitionLeft(begin, end) + 1;
+            continue;
+        }
+
+        bool alreadyPartitioned;
+        T* pivotPos = partitionRight(begin, end, alreadyPartitioned);
+        size_t leftSize = size_t(pivotPos - begin);
+        size_t rightSize = size_t(end - (pivotPos + 1));
+
+        if (leftSize < size / 8 || rightSize < size / 8) {
+            // Неудачное разбиение: после нескольких таких переходим на heapsort,
+            // иначе перемешиваем части, чтобы сломать неудачный шаблон входа.
+            if (--badAllowed == 0) {
+                heapSortArr(begin, end);
+                return;
+            }
+            if (leftSize >= INSERTION_SORT_THRESHOLD) {
+                swap(*begin, *(begin + leftSize / 4));
+                swap(*(pivotPos - 1), *(pivotPos - leftSize / 4));
+                if (leftSize > NINTHER_THRESHOLD) {
+                    swap(*(begin + 1), *(begin + (leftSize / 4 + 1)));
+                    swap(*(begin + 2), *(begin + (leftSize / 4 + 2)));
+                    swap(*(pivotPos - 2), *(pivotPos - (leftSize / 4 + 1)));
+                    swap(*(pivotPos - 3), *(pivotPos - (leftSize / 4 + 2)));
+                }
+            }
+            if (rightSize >= INSERTION_SORT_THRESHOLD) {
+                swap(*(pivotPos + 1), *(pivotPos + (1 + rightSize / 4)));
+                swap(*(end - 1), *(end - rightSize / 4));
+                if (rightSize > NINTHER_THRESHOLD) {
+                    swap(*(pivotPos + 2), *(pivotPos + (2 + rightSize / 4)));
+                    swap(*(pivotPos + 3), *(pivotPos + (3 + rightSize / 4)));
+                    swap(*(end - 2), *(end - (1 + rightSize / 4)));
+                    swap(*(end - 3), *(end - (2 + rightSize / 4)));
+                }
+            }
+        }
+        else if (alreadyPartitioned && partialInsertionSort(begin, pivotPos)
+            && partialInsertionSort(pivotPos + 1, end)) {
+            // Часть была почти отсортирована — досортировали вставками.
+            return;
+        }
+
+        if (leftSize < rightSize) {
+            sortLoop(begin, pivotPos, badAllowed, leftmost);
+            begin = pivotPos + 1;
+            leftmost = false;
+        }
+        else {
+            sortLoop(pivotPos + 1, end, badAllowed, false);
+            end = pivotPos;
+        }
+    }
+}
+
+/*
+ * Сортировка массива по возрастанию (pdqsort: быстрая сортировка с медианой
+ * из трёх или ninther, вставками на малых частях и heapsort при вырождении).
+ * От типа элемента нужны только копирование, operator< и swap.
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ */
+template <class T>
+void sortirovka(T* arr, size_t size) {
+    if (size < 2) return;
+    int badAllowed = 1;
+    for (size_t n = size; n > 1; n >>= 1) ++badAllowed;
+    sortLoop(arr, arr + size, badAllowed, true);
+}
+
+/*
+ * Границы части t при делении n элементов на parts частей.
+ * Длина части — n / parts с округлением вверх до кратной align, последняя
+ * часть всегда заканчивается на n, так что части покрывают весь диапазон
+ * (последние части могут оказаться пустыми).
+ *
+ * @param n число элементов.
+ * @param parts число частей.
+ * @param align кратность длины части.
+ * @param t номер части.
+ * @param begin начало части.
+ * @param end конец части.
+ */
+void sliceBounds(size_t n, unsigned parts, size_t align, unsigned t, size_t& begin, size_t& end) {
+    size_t slice = (n + parts - 1) / parts;
+    slice = (slice + align - 1) / align * align;
+    begin = min(n, size_t(t) * slice);
+    end = t + 1 == parts ? n : min(n, begin + slice);
+}
+
+/*
+ * Пул потоков с захватом работы (work stealing).
+ * У каждого потока своя очередь: свои задачи он берёт с конца (последние —
+ * самые «горячие» в кэше), а чужие забирает с начала, где лежат крупные задачи.
+ * Поток 0 — вызывающий поток, он тоже выполняет задачи, пока ждёт.
+ * Рабочий поток без задач недолго крутится, а затем засыпает до новой задачи.
+ */
+class WorkStealingPool {
+    struct Queue {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+    vector<unique_ptr<Queue>> queues;
+    vector<thread> workers;
+    atomic<bool> stopping{ false };
+    // Задач в очередях и спящих рабочих потоков.
+    atomic<size_t> queued{ 0 };
+    atomic<unsigned> sleeping{ 0 };
+    mutex idleLock;
+    condition_variable wake;
+
+    /* Сколько раз поток без задач уступает процессор, прежде чем заснуть. */
+    static const unsigned IDLE_SPINS = 64;
+
+    static int& currentSlot() {
+        static thread_local int slot = 0;
+        return slot;
+    }
+
+    bool popOwn(int slot, function<void()>& task) {
+        Queue& q = *queues[slot];
+        lock_guard<mutex> guard(q.lock);
+        if (q.tasks.empty()) return false;
+        task = move(q.tasks.back());
+        q.tasks.pop_back();
+        --queued;
+        return true;
+    }
+
+    bool steal(int slot, function<void()>& task) {
+        for (size_t k = 1; k < queues.size(); ++k) {
+            Queue& q = *queues[(slot + k) % queues.size()];
+            lock_guard<mutex> guard(q.lock);
+            if (q.tasks.empty()) continue;
+            task = move(q.tasks.front());
+            q.tasks.pop_front();
+            --queued;
+            return true;
+        }
+        return false;
+    }
+
+public:
+    /*
+     * Создаёт пул.
+     * @param threads общее число потоков вместе с вызывающим, 0 — по числу ядер.
+     */
+    explicit WorkStealingPool(unsigned threads) {
+        if (threads == 0) threads = thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        for (unsigned t = 0; t < threads; ++t) queues.emplace_back(new Queue);
+        for (unsigned t = 1; t < threads; ++t) {
+            workers.emplace_back([this, t] {
+                currentSlot() = int(t);
+                unsigned idle = 0;
+                while (!stopping.load(memory_order_relaxed)) {
+                    if (runOne()) { idle = 0; continue; }
+                    if (++idle < IDLE_SPINS) { this_thread::yield(); continue; }
+                    idle = 0;
+                    unique_lock<mutex> guard(idleLock);
+                    ++sleeping;
+                    wake.wait(guard, [this] { return stopping.load() || queued.load() != 0; });
+                    --sleeping;
+                }
+            });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            lock_guard<mutex> guard(idleLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /* Число потоков пула вместе с вызывающим. */
+    size_t size() const { return queues.size(); }
+
+    /*
+     * Кладёт задачу в очередь текущего потока.
+     */
+    void submit(function<void()> task) {
+        Queue& q = *queues[currentSlot() < int(queues.size()) ? currentSlot() : 0];
+        {
+            lock_guard<mutex> guard(q.lock);
+            q.tasks.push_back(move(task));
+            ++queued;
+        }
+        // Под idleLock: иначе сигнал может прийти между проверкой условия и засыпанием.
+        if (sleeping.load() != 0) {
+            lock_guard<mutex> guard(idleLock);
+            wake.notify_one();
+        }
+    }
+
+    /*
+     * Выполняет одну задачу: свою или украденную.
+     * @return false, если задач не нашлось.
+     */
+    bool runOne() {
+        int slot = currentSlot() < int(queues.size()) ? currentSlot() : 0;
+        function<void()> task;
+        if (!popOwn(slot, task) && !steal(slot, task)) return false;
+        task();
+        return true;
+    }
+
+    /*
+     * Ждёт обнуления счётчика, выполняя задачи пула вместо простоя.
+     */
+    void wait(const atomic<size_t>& pending) {
+        while (pending.load() != 0) {
+            if (!runOne()) this_thread::yield();
+        }
+    }
+};
+
+/*
+ * Части меньше этого размера сортируются последовательно, без создания задач.
+ */
+const size_t PARALLEL_SORT_CUTOFF = size_t(1) << 14;
+
+/*
+ * Задача параллельной быстрой сортировки: делит часть и отдаёт левую
+ * половину пулу, правую продолжает сама.
+ */
+void parallelSortTask(WorkStealingPool& pool, atomic<size_t>& pending, double* begin, double* end, int badAllowed) {
+    while (size_t(end - begin) > PARALLEL_SORT_CUTOFF) {
+        size_t size = size_t(end - begin);
+        choosePivot(begin, end);
+        bool alreadyPartitioned;
+        double* pivotPos = partitionRight(begin, end, alreadyPartitioned);
+        size_t leftSize = size_t(pivotPos - begin);
+        size_t rightSize = size_t(end - (pivotPos + 1));
+        // После нескольких неудачных разбиений отдаём часть последовательной
+        // сортировке — у неё есть переход на heapsort.
+        if ((leftSize < size / 8 || rightSize < size / 8) && --badAllowed == 0) break;
+
+        ++pending;
+        pool.submit([&pool, &pending, begin, pivotPos, badAllowed] {
+            parallelSortTask(pool, pending, begin, pivotPos, badAllowed);
+        });
+        begin = pivotPos + 1;
+    }
+    sortirovka(begin, size_t(end - begin));
+    --pending;
+}
+
+/*
+ * Параллельная сортировка массива: быстрая сортировка, части которой
+ * выполняются задачами на пуле с захватом работы. Результат совпадает
+ * с sortirovka.
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @param threads число потоков, 0 — по числу ядер.
+ */
+void sortirovkaParallel(double* arr, size_t size, unsigned threads) {
+    if (size <= PARALLEL_SORT_CUTOFF || threads == 1) {
+        sortirovka(arr, size);
+        return;
+    }
+    WorkStealingPool pool(threads);
+    atomic<size_t> pending{ 1 };
+    int badAllowed = 1;
+    for (size_t n = size; n > 1; n >>= 1) ++badAllowed;
+    pool.submit([&] { parallelSortTask(pool, pending, arr, arr + size, badAllowed); });
+    pool.wait(pending);
+}
+
+/*
+ * Параллельное устойчивое слияние двух отсортированных частей в out.
+ * Большая часть делится пополам, границу во второй находит двоичный поиск;
+ * при равенстве элементы первой части идут раньше.
+ */
+void parallelMerge(WorkStealingPool& pool, const double* a, size_t na, const double* b, size_t nb, double* out) {
+    while (na + nb > PARALLEL_SORT_CUTOFF) {
+        size_t ma, mb;
+        if (na >= nb) {
+            ma = na / 2;
+            mb = size_t(lower_bound(b, b + nb, a[ma]) - b);
+        }
+        else {
+            mb = nb / 2;
+            ma = size_t(upper_bound(a, a + na, b[mb]) - a);
+        }
+        atomic<size_t> pending{ 1 };
+        pool.submit([&pool, &pending, a, ma, b, mb, out] {
+            parallelMerge(pool, a, ma, b, mb, out);
+            --pending;
+        });
+        a += ma; na -= ma;
+        b += mb; nb -= mb;
+        out += ma + mb;
+        // Правую половину обрабатываем сами, затем ждём левую.
+        parallelMerge(pool, a, na, b, nb, out);
+        pool.wait(pending);
+        return;
+    }
+    merge(a, a + na, b, b + nb, out);
+}
+
+/*
+ * Параллельная сортировка слиянием. Данные лежат в arr, результат
+ * кладётся в arr (toBuffer = false) или в buffer (toBuffer = true).
+ */
+void parallelMergeSort(WorkStealingPool& pool, double* arr, double* buffer, size_t size, bool toBuffer) {
+    if (size <= PARALLEL_SORT_CUTOFF) {
+        stable_sort(arr, arr + size);
+        if (toBuffer) copy(arr, arr + size, buffer);
+        return;
+    }
+    size_t half = size / 2;
+    atomic<size_t> pending{ 1 };
+    // Половины сортируются в противоположный массив, затем сливаются в нужный.
+    pool.submit([&pool, &pending, arr, buffer, half, toBuffer] {
+        parallelMergeSort(pool, arr, buffer, half, !toBuffer);
+        --pending;
+    });
+    parallelMergeSort(pool, arr + half, buffer + half, size - half, !toBuffer);
+    pool.wait(pending);
+    if (toBuffer) parallelMerge(pool, arr, half, arr + half, size - half, buffer);
+    else parallelMerge(pool, buffer, half, buffer + half, size - half, arr);
+}
+
+/*
+ * Устойчивая параллельная сортировка слиянием
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @param threads число потоков, 0 — по числу ядер.
+ */
+void mergeSortParallel(double* arr, size_t size, unsigned threads) {
+    if (size < 2) return;
+    WorkStealingPool pool(threads);
+    vector<double> buffer(size);
+    parallelMergeSort(pool, arr, buffer.data(), size, false);
+}
+
+/*
+ * Ширина разряда поразрядной сортировки: 11 бит, шесть проходов на 64-битный ключ.
+ */
+const int RADIX_BITS = 11;
+const int RADIX_PASSES = (64 + RADIX_BITS - 1) / RADIX_BITS;
+const size_t RADIX_BUCKETS = size_t(1) << RADIX_BITS;
+
+/*
+ * Чтение и запись 64-битного ключа по адресу элемента массива.
+ * memcpy позволяет хранить ключи в памяти массива double без нарушения правил алиасинга.
+ */
+inline uint64_t loadKey(const void* base, size_t i) {
+    uint64_t key;
+    memcpy(&key, (const char*)base + i * sizeof(uint64_t), sizeof(key));
+    return key;
+}
+
+inline void storeKey(void* base, size_t i, uint64_t key) {
+    memcpy((char*)base + i * sizeof(uint64_t), &key, sizeof(key));
+}
+
+/*
+ * Переводит биты double в ключ, порядок которого как беззнакового числа
+ * совпадает с порядком чисел: у отрицательных инвертируются все биты,
+ * у положительных — только знаковый.
+ */
+inline uint64_t doubleToKey(uint64_t bits) {
+    return (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+}
+
+inline uint64_t keyToDouble(uint64_t key) {
+    return (key >> 63) ? key & ~(uint64_t(1) << 63) : ~key;
+}
+
+/*
+ * Поразрядная сортировка (LSD) массива double по 11-битным разрядам.
+ * Гистограммы всех разрядов строятся за один предварительный проход;
+ * разряд, одинаковый у всех элементов, пропускается. NaN (с любым знаком)
+ * переносятся в конец массива в исходном порядке, -0.0 ставится перед +0.0.
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @param scratch буфер на size элементов; если nullptr, выделяется внутри.
+ */
+void radixSort(double* arr, size_t size, uint64_t* scratch = nullptr) {
+    if (size < 2) return;
+    size_t count = size_t(stable_partition(arr, arr + size, [](double x) { return !isnan(x); }) - arr);
+    if (count < 2) return;
+
+    vector<uint64_t> ownScratch;
+    if (!scratch) {
+        ownScratch.resize(count);
+        scratch = ownScratch.data();
+    }
+
+    vector<size_t> histogram(RADIX_PASSES * RADIX_BUCKETS, 0);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = doubleToKey(loadKey(arr, i));
+        storeKey(arr, i, key);
+        for (int d = 0; d < RADIX_PASSES; ++d) {
+            ++histogram[d * RADIX_BUCKETS + ((key >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1))];
+        }
+    }
+
+    void* src = arr;
+    void* dst = scratch;
+    for (int d = 0; d < RADIX_PASSES; ++d) {
+        size_t* hist = &histogram[d * RADIX_BUCKETS];
+        int shift = d * RADIX_BITS;
+        // Все элементы в одной корзине — разряд ничего не меняет.
+        if (hist[(loadKey(src, 0) >> shift) & (RADIX_BUCKETS - 1)] == count) continue;
+
+        size_t offset = 0;
+        for (size_t b = 0; b < RADIX_BUCKETS; ++b) {
+            size_t c = hist[b];
+            hist[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t key = loadKey(src, i);
+            storeKey(dst, hist[(key >> shift) & (RADIX_BUCKETS - 1)]++, key);
+        }
+        swap(src, dst);
+    }
+
+    for (size_t i = 0; i < count; ++i) storeKey(arr, i, keyToDouble(loadKey(src, i)));
+}
+
+/*
+ * Алгоритм сортировки массива.
+ */
+enum SortBackend { QuickSort = 1, ParallelQuickSort = 2, RadixSort = 3 };
+
+/*
+ * Сортирует массив выбранным алгоритмом
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @param backend алгоритм сортировки.
+ */
+void sortArray(double* arr, size_t size, SortBackend backend) {
+    switch (backend) {
+    case QuickSort: sortirovka(arr, size); break;
+    case ParallelQuickSort: sortirovkaParallel(arr, size, 0); break;
+    case RadixSort: radixSort(arr, size); break;
+    }
+}
+
+/*
+ * Где лежит массив.
+ */
+enum ArrayBacking { HeapMemory = 1, HugePages = 2, FileMapping = 3 };
+
+/*
+ * Выравнивание начала массива: строка кэша и ширина AVX-512.
+ */
+const size_t ARRAY_ALIGNMENT = 64;
+
+/*
+ * Размер большой страницы, до которого округляется память под HugePages.
+ */
+const size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+/*
+ * Массив double с 64-битным размером, начало которого выровнено по 64 байтам.
+ * Память берётся обычным выделением, большими страницами или отображением
+ * файла: тогда массив может быть больше оперативной памяти, а данные
+ * остаются в файле после выхода.
+ */
+class DoubleArray {
+    double* ptr = nullptr;
+    size_t len = 0;
+    size_t bytes = 0;
+    ArrayBacking backing = HeapMemory;
+    bool opened = false;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+
+    void allocateHeap() {
+#ifdef _WIN32
+        ptr = (double*)_aligned_malloc(bytes, ARRAY_ALIGNMENT);
+#else
+        void* p = nullptr;
+        if (posix_memalign(&p, ARRAY_ALIGNMENT, bytes) == 0) ptr = (double*)p;
+#endif
+    }
+
+    void allocateHugePages() {
+#ifdef _WIN32
+        // Большие страницы Windows требуют привилегии SeLockMemoryPrivilege; без неё — обычные.
+        size_t page = GetLargePageMinimum();
+        if (page > 0) {
+            size_t rounded = (bytes + page - 1) / page * page;
+            ptr = (double*)VirtualAlloc(NULL, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (ptr) { bytes = rounded; return; }
+        }
+        ptr = (double*)VirtualAlloc(NULL, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+        size_t rounded = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+        void* p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) { ptr = (double*)p; bytes = rounded; return; }
+#endif
+        // Пул больших страниц не настроен: берём обычные, выровненные по 2 МиБ,
+        // и просим ядро собрать их в прозрачные большие страницы.
+        char* raw = (char*)mmap(nullptr, rounded + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == (char*)MAP_FAILED) return;
+        char* aligned = (char*)((uintptr_t(raw) + HUGE_PAGE_SIZE - 1) & ~uintptr_t(HUGE_PAGE_SIZE - 1));
+        if (aligned > raw) munmap(raw, size_t(aligned - raw));
+        size_t tail = size_t(raw + rounded + HUGE_PAGE_SIZE - (aligned + rounded));
+        if (tail > 0) munmap(aligned + rounded, tail);
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, rounded, MADV_HUGEPAGE);
+#endif
+        ptr = (double*)aligned;
+        bytes = rounded;
+#endif
+    }
+
+    void mapFile(const string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return;
+        // Отображение размера больше файла само растягивает файл.
+        mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, DWORD(uint64_t(bytes) >> 32), DWORD(bytes), NULL);
+        if (!mapping) return;
+        ptr = (double*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+#else
+        int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return;
+        if (ftruncate(fd, off_t(bytes)) == 0) {
+            void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) ptr = (double*)p;
+        }
+        close(fd);
+#endif
+    }
+
+    void release() {
+        if (ptr) {
+#ifdef _WIN32
+            if (backing == HeapMemory) _aligned_free(ptr);
+            else if (backing == HugePages) VirtualFree(ptr, 0, MEM_RELEASE);
+            else UnmapViewOfFile(ptr);
+#else
+            if (backing == HeapMemory) free(ptr);
+            else munmap(ptr, bytes);
+#endif
+        }
+#ifdef _WIN32
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#endif
+        ptr = nullptr;
+        len = bytes = 0;
+        opened = false;
+    }
+
+public:
+    DoubleArray() : opened(true) {}
+
+    /*
+     * Выделяет массив
+     *
+     * @param size число элементов.
+     * @param kind где разместить массив.
+     * @param path файл для FileMapping; создаётся или растягивается до нужного размера.
+     */
+    explicit DoubleArray(size_t size, ArrayBacking kind = HeapMemory, const string& path = "") : backing(kind) {
+        if (size == 0) { opened = true; return; }
+        if (size > SIZE_MAX / sizeof(double)) return;
+        bytes = size * sizeof(double);
+        switch (kind) {
+        case HugePages: allocateHugePages(); break;
+        case FileMapping: mapFile(path); break;
+        default: backing = HeapMemory; allocateHeap(); break;
+        }
+        if (ptr) {
+            len = size;
+            opened = true;
+        } else {
+            release();
+        }
+    }
+
+    ~DoubleArray() { release(); }
+
+    DoubleArray(const DoubleArray&) = delete;
+    DoubleArray& operator=(const DoubleArray&) = delete;
+
+    DoubleArray(DoubleArray&& other) noexcept { swap(other); }
+
+    DoubleArray& operator=(DoubleArray&& other) noexcept {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    void swap(DoubleArray& other) noexcept {
+        std::swap(ptr, other.ptr);
+        std::swap(len, other.len);
+        std::swap(bytes, other.bytes);
+        std::swap(backing, other.backing);
+        std::swap(opened, other.opened);
+#ifdef _WIN32
+        std::swap(file, other.file);
+        std::swap(mapping, other.mapping);
+#endif
+    }
+
+    /* Удалось ли выделить память (массив нулевой длины тоже считается выделенным). */
+    bool isOpen() const { return opened; }
+    double* data() { return ptr; }
+    const double* data() const { return ptr; }
+    size_t size() const { return len; }
+    double& operator[](size_t i) { return ptr[i]; }
+    double operator[](size_t i) const { return ptr[i]; }
+    double* begin() { return ptr; }
+    double* end() { return ptr + len; }
+    const double* begin() const { return ptr; }
+    const double* end() const { return ptr + len; }
+};
+
+/*
+ * Диапазон случайных частот массива.
+ */
+const double FREQ_MIN = 20;
+const double FREQ_MAX = 20000;
+
+/*
+ * Константы генератора Philox4x32-10 (Salmon и др., «Parallel random numbers:
+ * as easy as 1, 2, 3»): множители раундов и приращения ключа.
+ */
+const uint32_t PHILOX_M0 = 0xD2511F53u;
+const uint32_t PHILOX_M1 = 0xCD9E8D57u;
+const uint32_t PHILOX_W0 = 0x9E3779B9u;
+const uint32_t PHILOX_W1 = 0xBB67AE85u;
+const int PHILOX_ROUNDS = 10;
+
+/*
+ * Число элементов, которые даёт один вызов генератора: 4 счётчика по 128 бит,
+ * из каждого — два числа.
+ */
+const size_t RANDOM_GROUP = 8;
+
+/*
+ * Переводит 64 случайных бита в частоту: старшие 52 бита становятся мантиссой
+ * числа из [1, 2), которое затем сдвигается в [FREQ_MIN, FREQ_MAX).
+ */
+inline double bitsToFreq(uint64_t bits) {
+    uint64_t mantissa = (bits >> 12) | 0x3FF0000000000000ull;
+    double u;
+    memcpy(&u, &mantissa, sizeof(u));
+    return FREQ_MIN + (FREQ_MAX - FREQ_MIN) * (u - 1.0);
+}
+
+/*
+ * Вычисляет элементы 8g..8g+7 случайного массива. Генератор счётный: элемент i
+ * зависит только от (seed, i), поэтому любую часть массива можно заполнить
+ * независимо. Счётчик 4g+c шифруется ключом seed за 10 раундов Philox;
+ * слова 0–1 дают элемент 8g+2c, слова 2–3 — элемент 8g+2c+1.
+ *
+ * @param seed ключ генератора.
+ * @param group номер группы g.
+ * @param out 8 элементов результата.
+ */
+void randomGroup(uint64_t seed, uint64_t group, double* out) {
+#if defined(__AVX2__)
+    // Четыре счётчика обрабатываются параллельно, каждое 32-битное слово — в своей 64-битной полосе.
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i m0 = _mm256_set1_epi64x(PHILOX_M0), m1 = _mm256_set1_epi64x(PHILOX_M1);
+    uint64_t first = group * 4;
+    __m256i ctr = _mm256_add_epi64(_mm256_set1_epi64x(int64_t(first)), _mm256_set_epi64x(3, 2, 1, 0));
+    __m256i c0 = _mm256_and_si256(ctr, low), c1 = _mm256_srli_epi64(ctr, 32);
+    __m256i c2 = _mm256_setzero_si256(), c3 = _mm256_setzero_si256();
+    uint32_t k0 = uint32_t(seed), k1 = uint32_t(seed >> 32);
+    for (int r = 0; r < PHILOX_ROUNDS; ++r) {
+        __m256i p0 = _mm256_mul_epu32(c0, m0), p1 = _mm256_mul_epu32(c2, m1);
+        __m256i n0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), _mm256_set1_epi64x(k0));
+        __m256i n2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), _mm256_set1_epi64x(k1));
+        c1 = _mm256_and_si256(p1, low);
+        c3 = _mm256_and_si256(p0, low);
+        c0 = n0;
+        c2 = n2;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    __m256i bitsA = _mm256_or_si256(_mm256_slli_epi64(c0, 32), c1);
+    __m256i bitsB = _mm256_or_si256(_mm256_slli_epi64(c2, 32), c3);
+    const __m256i one = _mm256_set1_epi64x(0x3FF0000000000000ll);
+    __m256d a = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bitsA, 12), one)), _mm256_set1_pd(1.0));
+    __m256d b = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bitsB, 12), one)), _mm256_set1_pd(1.0));
+    const __m256d span = _mm256_set1_pd(FREQ_MAX - FREQ_MIN), base = _mm256_set1_pd(FREQ_MIN);
+    a = _mm256_add_pd(base, _mm256_mul_pd(span, a));
+    b = _mm256_add_pd(base, _mm256_mul_pd(span, b));
+    // a = A0 A1 A2 A3, b = B0 B1 B2 B3 -> A0 B0 A1 B1 | A2 B2 A3 B3
+    __m256d lo = _mm256_unpacklo_pd(a, b), hi = _mm256_unpackhi_pd(a, b);
+    _mm256_storeu_pd(out, _mm256_permute2f128_pd(lo, hi, 0x20));
+    _mm256_storeu_pd(out + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+#else
+    for (uint64_t c = 0; c < 4; ++c) {
+        uint64_t ctr = group * 4 + c;
+        uint32_t x0 = uint32_t(ctr), x1 = uint32_t(ctr >> 32), x2 = 0, x3 = 0;
+        uint32_t k0 = uint32_t(seed), k1 = uint32_t(seed >> 32);
+        for (int r = 0; r < PHILOX_ROUNDS; ++r) {
+            uint64_t p0 = uint64_t(PHILOX_M0) * x0, p1 = uint64_t(PHILOX_M1) * x2;
+            x0 = uint32_t(p1 >> 32) ^ x1 ^ k0;
+            x2 = uint32_t(p0 >> 32) ^ x3 ^ k1;
+            x1 = uint32_t(p1);
+            x3 = uint32_t(p0);
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        out[2 * c] = bitsToFreq(uint64_t(x0) << 32 | x1);
+        out[2 * c + 1] = bitsToFreq(uint64_t(x2) << 32 | x3);
+    }
+#endif
+}
+
+/*
+ * Заполняет элементы [begin, end) массива. Каждая группа из RANDOM_GROUP
+ * элементов считается одним и тем же кодом независимо от границ части,
+ * поэтому результат не зависит от разбиения на потоки.
+ */
+void fillRange(double* arr, size_t begin, size_t end, uint64_t seed) {
+    double tmp[RANDOM_GROUP];
+    size_t i = begin;
+    while (i < end) {
+        size_t offset = i % RANDOM_GROUP;
+        if (offset == 0 && end - i >= RANDOM_GROUP) {
+            randomGroup(seed, i / RANDOM_GROUP, arr + i);
+            i += RANDOM_GROUP;
+        } else {
+            randomGroup(seed, i / RANDOM_GROUP, tmp);
+            size_t take = min(RANDOM_GROUP - offset, end - i);
+            memcpy(arr + i, tmp + offset, take * sizeof(double));
+            i += take;
+        }
+    }
+}
+
+/*
+ * Заполнение массива случайными частотами из [FREQ_MIN, FREQ_MAX).
+ * Элемент i зависит только от seed и i: при одном seed массив одинаков
+ * при любом числе потоков.
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @param seed зерно генератора.
+ * @param threads число потоков, 0 — по числу ядер.
+ */
+void fillArray(double* arr, size_t size, uint64_t seed, unsigned threads = 0) {
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    const size_t minSlice = size_t(1) << 16;
+    if (threads > size / minSlice + 1) threads = unsigned(size / minSlice + 1);
+    vector<thread> pool;
+    size_t begin, end;
+    for (unsigned t = 1; t < threads; ++t) {
+        sliceBounds(size, threads, RANDOM_GROUP, t, begin, end);
+        if (begin < end) pool.emplace_back(fillRange, arr, begin, end, seed);
+    }
+    sliceBounds(size, threads, RANDOM_GROUP, 0, begin, end);
+    fillRange(arr, begin, end, seed);
+    for (auto& th : pool) th.join();
+}
+
+/*
+ * Поиск максимального значения в массиве
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @return максимальное значение.
+ */
+double findMax(const double* arr, size_t size) {
+    double max = arr[0];
+    for (size_t i = 1; i < size; ++i) if (max < arr[i]) max = arr[i];
+    return max;
+}
+
+/*
+ * Поиск минимального значения в массиве
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @return минимальное значение.
+ */
+double findMin(const double* arr, size_t size) {
+    double min = arr[0];
+    for (size_t i = 1; i < size; ++i) if (min > arr[i]) min = arr[i];
+    return min;
+}
+
+/*
+ * Вычисление среднего арифметического
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @return среднее значение.
+ */
+double avg(const double* arr, size_t size) {
+    double sum = 0;
+    for (size_t i = 0; i < size; ++i) sum += arr[i];
+    return sum / size;
+}
+
+/*
+ * Итоги свёртки массива за один проход.
+ */
+struct ArrayStats {
+    double min = 0;
+    double max = 0;
+    double sum = 0;
+    double sumSq = 0;
+    size_t count = 0;
+
+    /* Среднее арифметическое. */
+    double mean() const { return count ? sum / double(count) : 0; }
+    /* Дисперсия (смещённая). */
+    double variance() const { return count ? sumSq / double(count) - mean() * mean() : 0; }
+};
+
+/*
+ * Сумма с компенсацией ошибки округления (Ноймайер).
+ */
+struct KahanSum {
+    double sum = 0;
+    double carry = 0;
+
+    void add(double x) {
+        double t = sum + x;
+        if (fabs(sum) >= fabs(x)) carry += (sum - t) + x;
+        else carry += (x - t) + sum;
+        sum = t;
+    }
+
+    double value() const { return sum + carry; }
+};
+
+/*
+ * Размер блока свёртки. Внутри блока сумма копится в нескольких независимых
+ * аккумуляторах, а суммы блоков складываются с компенсацией, так что ошибка
+ * не растёт с длиной массива.
+ */
+const size_t REDUCE_BLOCK = 1024;
+
+/*
+ * Свёртка одного блока: минимум, максимум, сумма и сумма квадратов
+ *
+ * @param p указатель на блок.
+ * @param n размер блока (не меньше 1).
+ * @param stats результат для блока.
+ */
+void reduceBlock(const double* p, size_t n, ArrayStats& stats) {
+    size_t i = 0;
+    double mn = p[0], mx = p[0], sum = 0, sumSq = 0;
+#if defined(__AVX2__)
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+    __m256d mn0 = _mm256_set1_pd(mn), mn1 = mn0, mx0 = mn0, mx1 = mn0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d x0 = _mm256_loadu_pd(p + i);
+        __m256d x1 = _mm256_loadu_pd(p + i + 4);
+        s0 = _mm256_add_pd(s0, x0);
+        s1 = _mm256_add_pd(s1, x1);
+        q0 = _mm256_add_pd(q0, _mm256_mul_pd(x0, x0));
+        q1 = _mm256_add_pd(q1, _mm256_mul_pd(x1, x1));
+        mn0 = _mm256_min_pd(mn0, x0);
+        mn1 = _mm256_min_pd(mn1, x1);
+        mx0 = _mm256_max_pd(mx0, x0);
+        mx1 = _mm256_max_pd(mx1, x1);
+    }
+    alignas(32) double lanes[4][4];
+    _mm256_store_pd(lanes[0], _mm256_add_pd(s0, s1));
+    _mm256_store_pd(lanes[1], _mm256_add_pd(q0, q1));
+    _mm256_store_pd(lanes[2], _mm256_min_pd(mn0, mn1));
+    _mm256_store_pd(lanes[3], _mm256_max_pd(mx0, mx1));
+    for (int k = 0; k < 4; ++k) {
+        sum += lanes[0][k];
+        sumSq += lanes[1][k];
+        if (lanes[2][k] < mn) mn = lanes[2][k];
+        if (lanes[3][k] > mx) mx = lanes[3][k];
+    }
+#else
+    // Четыре независимых аккумулятора разрывают цепочку зависимостей по сумме.
+    double s[4] = { 0, 0, 0, 0 }, q[4] = { 0, 0, 0, 0 };
+    double lo[4] = { mn, mn, mn, mn }, hi[4] = { mx, mx, mx, mx };
+    for (; i + 4 <= n; i += 4) {
+        for (int k = 0; k < 4; ++k) {
+            double x = p[i + k];
+            s[k] += x;
+            q[k] += x * x;
+            lo[k] = x < lo[k] ? x : lo[k];
+            hi[k] = x > hi[k] ? x : hi[k];
+        }
+    }
+    for (int k = 0; k < 4; ++k) {
+        sum += s[k];
+        sumSq += q[k];
+        if (lo[k] < mn) mn = lo[k];
+        if (hi[k] > mx) mx = hi[k];
+    }
+#endif
+    for (; i < n; ++i) {
+        sum += p[i];
+        sumSq += p[i] * p[i];
+        if (p[i] < mn) mn = p[i];
+        if (p[i] > mx) mx = p[i];
+    }
+    stats.min = mn;
+    stats.max = mx;
+    stats.sum = sum;
+    stats.sumSq = sumSq;
+    stats.count = n;
+}
+
+/*
+ * Свёртка части массива блоками с компенсированным сложением сумм блоков
+ */
+ArrayStats reduceRange(const double* arr, size_t size) {
+    ArrayStats result;
+    if (size == 0) return result;
+    KahanSum sum, sumSq;
+    result.min = result.max = arr[0];
+    for (size_t pos = 0; pos < size; pos += REDUCE_BLOCK) {
+        ArrayStats block;
+        reduceBlock(arr + pos, size - pos < REDUCE_BLOCK ? size - pos : REDUCE_BLOCK, block);
+        sum.add(block.sum);
+        sumSq.add(block.sumSq);
+        if (block.min < result.min) result.min = block.min;
+        if (block.max > result.max) result.max = block.max;
+    }
+    result.sum = sum.value();
+    result.sumSq = sumSq.value();
+    result.count = size;
+    return result;
+}
+
+/*
+ * Число элементов в одной частичной свёртке. Части не зависят от числа
+ * потоков, а их итоги складываются всегда по порядку, поэтому результат
+ * побитово один и тот же при любом числе потоков.
+ */
+const size_t REDUCE_CHUNK = REDUCE_BLOCK * 64;
+
+/*
+ * Минимум, максимум, сумма, число элементов и сумма квадратов за один проход
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @param threads число потоков, 0 — по числу ядер.
+ * @param sorted массив отсортирован: минимум и максимум берутся с концов.
+ * @return возвращает статистику массива.
+ */
+ArrayStats reduceStats(const double* arr, size_t size, unsigned threads = 1, bool sorted = false) {
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    size_t chunks = (size + REDUCE_CHUNK - 1) / REDUCE_CHUNK;
+    if (threads > chunks) threads = chunks > 0 ? unsigned(chunks) : 1;
+
+    vector<ArrayStats> partial(chunks);
+    auto worker = [&partial, arr, size, chunks, threads](unsigned t) {
+        size_t first, last;
+        sliceBounds(chunks, threads, 1, t, first, last);
+        for (size_t c = first; c < last; ++c) {
+            size_t begin = c * REDUCE_CHUNK;
+            partial[c] = reduceRange(arr + begin, size - begin < REDUCE_CHUNK ? size - begin : REDUCE_CHUNK);
+        }
+    };
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    ArrayStats result;
+    if (chunks > 0) result.min = result.max = partial[0].min;
+    KahanSum sum, sumSq;
+    for (const ArrayStats& part : partial) {
+        sum.add(part.sum);
+        sumSq.add(part.sumSq);
+        if (part.min < result.min) result.min = part.min;
+        if (part.max > result.max) result.max = part.max;
+    }
+    result.sum = sum.value();
+    result.sumSq = sumSq.value();
+    result.count = size;
+    if (sorted && size > 0) {
+        result.min = arr[0];
+        result.max = arr[size - 1];
+    }
+    return result;
+}
+
+/*
+ * Минимум и максимум массива. Для отсортированного массива — за O(1).
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @param sorted массив отсортирован по возрастанию.
+ * @param min минимальное значение.
+ * @param max максимальное значение.
+ */
+void findMinMax(const double* arr, size_t size, bool sorted, double& min, double& max) {
+    if (size == 0) { min = max = 0; return; }
+    if (sorted) {
+        min = arr[0];
+        max = arr[size - 1];
+        return;
+    }
+    ArrayStats stats = reduceStats(arr, size, 0);
+    min = stats.min;
+    max = stats.max;
+}
+
+/*
+ * Ленивые поэлементные выражения над массивами.
+ * Запись вида view(arr) * index() + 100 строит лишь небольшое дерево из
+ * указателей и чисел; значения считаются в одном цикле только при
+ * вычислении в массив или при свёртке, без промежуточных массивов.
+ * Длина выражения — длина входящего в него массива; index() и числа длины
+ * не имеют (size() == 0) и подстраиваются под соседа.
+ */
+template <class E>
+struct ArrayExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+/*
+ * Лист выражения: элементы существующего массива.
+ */
+struct ArrayView : ArrayExpr<ArrayView> {
+    const double* ptr;
+    size_t len;
+
+    ArrayView(const double* p, size_t n) : ptr(p), len(n) {}
+    double operator[](size_t i) const { return ptr[i]; }
+    size_t size() const { return len; }
+};
+
+/*
+ * Лист выражения: номер элемента.
+ */
+struct IndexExpr : ArrayExpr<IndexExpr> {
+    double operator[](size_t i) const { return double(i); }
+    size_t size() const { return 0; }
+};
+
+/*
+ * Лист выражения: одно число для всех элементов.
+ */
+struct ScalarExpr : ArrayExpr<ScalarExpr> {
+    double value;
+
+    explicit ScalarExpr(double v) : value(v) {}
+    double operator[](size_t) const { return value; }
+    size_t size() const { return 0; }
+};
+
+struct AddOp { static double apply(double a, double b) { return a + b; } };
+struct SubOp { static double apply(double a, double b) { return a - b; } };
+struct MulOp { static double apply(double a, double b) { return a * b; } };
+struct DivOp { static double apply(double a, double b) { return a / b; } };
+
+/*
+ * Узел выражения: поэлементная операция над двумя подвыражениями.
+ * Подвыражения хранятся по значению, поэтому выражение можно сохранить в auto.
+ */
+template <class L, class R, class Op>
+struct BinaryExpr : ArrayExpr<BinaryExpr<L, R, Op>> {
+    L left;
+    R right;
+
+    BinaryExpr(const L& l, const R& r) : left(l), right(r) {}
+    double operator[](size_t i) const { return Op::apply(left[i], right[i]); }
+    size_t size() const { return left.size() ? left.size() : right.size(); }
+};
+
+template <class Op, class L, class R>
+BinaryExpr<L, R, Op> makeExpr(const ArrayExpr<L>& l, const ArrayExpr<R>& r) { return BinaryExpr<L, R, Op>(l.self(), r.self()); }
+
+template <class L, class R> BinaryExpr<L, R, AddOp> operator+(const ArrayExpr<L>& l, const ArrayExpr<R>& r) { return makeExpr<AddOp>(l, r); }
+template <class L, class R> BinaryExpr<L, R, SubOp> operator-(const ArrayExpr<L>& l, const ArrayExpr<R>& r) { return makeExpr<SubOp>(l, r); }
+template <class L, class R> BinaryExpr<L, R, MulOp> operator*(const ArrayExpr<L>& l, const ArrayExpr<R>& r) { return makeExpr<MulOp>(l, r); }
+template <class L, class R> BinaryExpr<L, R, DivOp> operator/(const ArrayExpr<L>& l, const ArrayExpr<R>& r) { return makeExpr<DivOp>(l, r); }
+template <class L> BinaryExpr<L, ScalarExpr, AddOp> operator+(const ArrayExpr<L>& l, double r) { return makeExpr<AddOp>(l, ScalarExpr(r)); }
+template <class L> BinaryExpr<L, ScalarExpr, SubOp> operator-(const ArrayExpr<L>& l, double r) { return makeExpr<SubOp>(l, ScalarExpr(r)); }
+template <class L> BinaryExpr<L, ScalarExpr, MulOp> operator*(const ArrayExpr<L>& l, double r) { return makeExpr<MulOp>(l, ScalarExpr(r)); }
+template <class L> BinaryExpr<L, ScalarExpr, DivOp> operator/(const ArrayExpr<L>& l, double r) { return makeExpr<DivOp>(l, ScalarExpr(r)); }
+template <class R> BinaryExpr<ScalarExpr, R, AddOp> operator+(double l, const ArrayExpr<R>& r) { return makeExpr<AddOp>(ScalarExpr(l), r); }
+template <class R> BinaryExpr<ScalarExpr, R, SubOp> operator-(double l, const ArrayExpr<R>& r) { return makeExpr<SubOp>(ScalarExpr(l), r); }
+template <class R> BinaryExpr<ScalarExpr, R, MulOp> operator*(double l, const ArrayExpr<R>& r) { return makeExpr<MulOp>(ScalarExpr(l), r); }
+template <class R> BinaryExpr<ScalarExpr, R, DivOp> operator/(double l, const ArrayExpr<R>& r) { return makeExpr<DivOp>(ScalarExpr(l), r); }
+
+inline ArrayView view(const double* arr, size_t size) { return ArrayView(arr, size); }
+inline ArrayView view(const DoubleArray& arr) { return ArrayView(arr.data(), arr.size()); }
+inline IndexExpr index() { return IndexExpr(); }
+
+/*
+ * Вычисляет часть выражения в буфер. Тело цикла — встроенное дерево
+ * операций без ветвлений, компилятор векторизует его.
+ *
+ * @param expr выражение.
+ * @param begin номер первого элемента.
+ * @param count число элементов.
+ * @param out буфер результата (может совпадать с массивом из выражения).
+ */
+template <class E>
+void evaluate(const ArrayExpr<E>& expr, size_t begin, size_t count, double* out) {
+    const E& e = expr.self();
+    for (size_t i = 0; i < count; ++i) out[i] = e[begin + i];
+}
+
+/*
+ * Вычисляет всё выражение в новый массив
+ */
+template <class E>
+DoubleArray materialize(const ArrayExpr<E>& expr) {
+    DoubleArray result(expr.self().size());
+    if (!result.isOpen()) throw bad_alloc();
+    evaluate(expr, 0, result.size(), result.data());
+    return result;
+}
+
+/*
+ * Минимум, максимум, сумма и сумма квадратов выражения за один проход.
+ * Выражение вычисляется блоками по REDUCE_BLOCK элементов в буфер на стеке,
+ * который сразу сворачивается, пока лежит в L1: массив целиком не создаётся.
+ */
+template <class E>
+ArrayStats reduceStats(const ArrayExpr<E>& expr) {
+    ArrayStats result;
+    size_t size = expr.self().size();
+    if (size == 0) return result;
+    alignas(64) double block[REDUCE_BLOCK];
+    KahanSum sum, sumSq;
+    for (size_t pos = 0; pos < size; pos += REDUCE_BLOCK) {
+        size_t len = size - pos < REDUCE_BLOCK ? size - pos : REDUCE_BLOCK;
+        evaluate(expr, pos, len, block);
+        ArrayStats part;
+        reduceBlock(block, len, part);
+        sum.add(part.sum);
+        sumSq.add(part.sumSq);
+        if (pos == 0 || part.min < result.min) result.min = part.min;
+        if (pos == 0 || part.max > result.max) result.max = part.max;
+    }
+    result.sum = sum.value();
+    result.sumSq = sumSq.value();
+    result.count = size;
+    return result;
+}
+
+template <class E> double findMax(const ArrayExpr<E>& expr) { return reduceStats(expr).max; }
+template <class E> double findMin(const ArrayExpr<E>& expr) { return reduceStats(expr).min; }
+template <class E> double avg(const ArrayExpr<E>& expr) { return reduceStats(expr).mean(); }
+
+/*
+ * Размер буфера вывода массива и запас в нём под одну строку
+ * (число в фиксированной записи занимает до ~320 символов).
+ */
+const size_t OUTPUT_BUFFER = size_t(1) << 20;
+const size_t OUTPUT_LINE_RESERVE = 512;
+
+/*
+ * Вывод значений выражения строками "номер: значение" (как printf "%zu: %f").
+ * Строки форматируются std::to_chars в буфер на 1 МиБ, который пишется
+ * в поток целиком, без вызова printf на каждое число.
+ *
+ * @param expr выражение или view(массив).
+ * @param out поток вывода.
+ * @return возвращает false при ошибке записи.
+ */
+template <class E>
+bool writeArray(const ArrayExpr<E>& expr, ostream& out) {
+    const E& e = expr.self();
+    vector<char> buffer(OUTPUT_BUFFER);
+    char* const begin = buffer.data();
+    char* const end = begin + buffer.size();
+    char* p = begin;
+    for (size_t i = 0; i < e.size(); ++i) {
+        if (size_t(end - p) < OUTPUT_LINE_RESERVE) {
+            out.write(begin, p - begin);
+            p = begin;
+        }
+        p = to_chars(p, end, i + 1).ptr;
+        *p++ = ':';
+        *p++ = ' ';
+        p = to_chars(p, end, e[i], chars_format::fixed, 6).ptr;
+        *p++ = '\n';
+    }
+    out.write(begin, p - begin);
+    out.flush();
+    return bool(out);
+}
+
+/*
+ * Вывод значений выражения на экран без вычисления в массив
+ */
+template <class E>
+void printArray(const ArrayExpr<E>& expr) {
+    writeArray(expr, cout);
+}
+
+/*
+ * Вывод массива на экран
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ */
+void printArray(const double* arr, size_t size) {
+    writeArray(view(arr, size), cout);
+}
+
+/*
+ * Вычисление медианы
  *
  * @param arr указатель на массив.
- * @param min минимальный индекс.
- * @param max максимальный индекс.
- * @return возвращает индекс разделения для рекурсии.
+ * @param size размер массива.
+ * @return медианное значение.
  */
-int swapArr(double* arr, int min, int max) {
-    double pivot = arr[(min + max) / 2];
-    int i = min, j = max;
+double median(const double* arr, size_t size) {
+    return (size % 2 != 0) ? arr[(size - 1) / 2] : (arr[size / 2 - 1] + arr[size / 2]) / 2.0;
+}
 
-    while (i <= j) {
-        while (arr[i] < pivot) ++i;
-        while (arr[j] > pivot) --j;
-        if (i <= j) {
+/*
+ * Ставит на место k элемент, который стоял бы там после сортировки
+ * (алгоритм Флойда — Ривеста). Слева от k оказываются элементы не больше,
+ * справа — не меньше. Ожидаемое время O(n); если итераций слишком много,
+ * досчитывает через nth_element.
+ *
+ * @param arr указатель на массив.
+ * @param left левая граница части (включительно).
+ * @param right правая граница части (включительно).
+ * @param k искомый индекс.
+ */
+void floydRivest(double* arr, long long left, long long right, long long k) {
+    int rounds = 0;
+    while (right > left) {
+        if (++rounds > 64) {
+            nth_element(arr + left, arr + k, arr + right + 1);
+            return;
+        }
+        // На большой части сначала сужаем окно вокруг k по выборке.
+        if (right - left > 600) {
+            double n = double(right - left + 1);
+            double i = double(k - left + 1);
+            double z = log(n);
+            double s = 0.5 * exp(2 * z / 3);
+            double sd = 0.5 * sqrt(z * s * (n - s) / n) * (i - n / 2 < 0 ? -1 : 1);
+            long long newLeft = max(left, (long long)(double(k) - i * s / n + sd));
+            long long newRight = min(right, (long long)(double(k) + (n - i) * s / n + sd));
+            floydRivest(arr, newLeft, newRight, k);
+        }
+        double t = arr[k];
+        long long i = left, j = right;
+        swap(arr[left], arr[k]);
+        if (arr[right] > t) swap(arr[right], arr[left]);
+        while (i < j) {
             swap(arr[i], arr[j]);
             ++i;
             --j;
+            while (arr[i] < t) ++i;
+            while (arr[j] > t) --j;
         }
+        if (arr[left] == t) swap(arr[left], arr[j]);
+        else {
+            ++j;
+            swap(arr[j], arr[right]);
+        }
+        if (j <= k) left = j + 1;
+        if (k <= j) right = j - 1;
     }
-    return i;
 }
 
 /*
- * Быстрая сортировка массива
+ * k-я порядковая статистика без полной сортировки (массив переупорядочивается)
  *
  * @param arr указатель на массив.
- * @param min минимальный индекс.
- * @param max максимальный индекс.
+ * @param size размер массива.
+ * @param k индекс от 0 до size - 1.
+ * @return возвращает элемент, который стоял бы на месте k после сортировки.
  */
-void sortirovka(double* arr, int min, int max) {
-    if (min >= max) return;
-    int mid = swapArr(arr, min, max);
-    sortirovka(arr, min, mid - 1);
-    sortirovka(arr, mid, max);
+double selectKth(double* arr, size_t size, size_t k) {
+    floydRivest(arr, 0, (long long)size - 1, (long long)k);
+    return arr[k];
 }
 
 /*
- * Заполнение массива случайными числами
+ * Медиана за O(n) на неотсортированном массиве (массив переупорядочивается)
  *
  * @param arr указатель на массив.
  * @param size размер массива.
+ * @return медианное значение.
  */
-void fillArray(double* arr, int size) {
-    for (int i = 0; i < size; ++i) arr[i] = 20 + (20000 - 20) * rand() / double(RAND_MAX);
+double medianSelect(double* arr, size_t size) {
+    if (size == 0) return 0;
+    double upper = selectKth(arr, size, size / 2);
+    if (size % 2 != 0) return upper;
+    // Нижняя из средних — максимум левой части, она уже отделена выбором.
+    double lower = *max_element(arr, arr + size / 2);
+    return (lower + upper) / 2.0;
 }
 
 /*
- * Вывод массива на экран
- *
- * @param arr указатель на массив.
- * @param size размер массива.
+ * Выбирает сразу несколько порядковых статистик: каждая делит массив,
+ * остальные ищутся только в своей части.
  */
-void printArray(double* arr, int size) {
-    for (int i = 0; i < size; ++i) printf("%d: %f\n", i + 1, arr[i]);
+void multiSelect(double* arr, long long left, long long right, const size_t* ranks, size_t count) {
+    if (count == 0 || left > right) return;
+    size_t mid = count / 2;
+    long long k = (long long)ranks[mid];
+    floydRivest(arr, left, right, k);
+    multiSelect(arr, left, k - 1, ranks, mid);
+    multiSelect(arr, k + 1, right, ranks + mid + 1, count - mid - 1);
 }
 
 /*
- * Поиск максимального значения в массиве
+ * Перцентили за O(n log m) для m запросов на неотсортированном массиве
+ * (массив переупорядочивается). Между соседними элементами значение
+ * интерполируется линейно, как у median.
  *
  * @param arr указатель на массив.
  * @param size размер массива.
- * @return максимальное значение.
+ * @param ps доли от 0 до 1 (например, 0.5, 0.9, 0.99).
+ * @return возвращает значения перцентилей в порядке запросов.
  */
-double findMax(double* arr, int size) {
-    double max = arr[0];
-    for (int i = 1; i < size; ++i) if (max < arr[i]) max = arr[i];
-    return max;
+vector<double> percentilesSelect(double* arr, size_t size, const vector<double>& ps) {
+    vector<double> result(ps.size(), 0);
+    if (size == 0) return result;
+    vector<size_t> ranks;
+    for (double p : ps) {
+        double h = (size - 1) * min(max(p, 0.0), 1.0);
+        size_t lo = size_t(h);
+        ranks.push_back(lo);
+        if (lo + 1 < size) ranks.push_back(lo + 1);
+    }
+    sort(ranks.begin(), ranks.end());
+    ranks.erase(unique(ranks.begin(), ranks.end()), ranks.end());
+    multiSelect(arr, 0, (long long)size - 1, ranks.data(), ranks.size());
+    for (size_t q = 0; q < ps.size(); ++q) {
+        double h = (size - 1) * min(max(ps[q], 0.0), 1.0);
+        size_t lo = size_t(h);
+        result[q] = lo + 1 < size ? arr[lo] + (h - double(lo)) * (arr[lo + 1] - arr[lo]) : arr[lo];
+    }
+    return result;
 }
 
 /*
- * Поиск минимального значения в массиве
- *
- * @param arr указатель на массив.
- * @param size размер массива.
- * @return минимальное значение.
+ * Точная медиана потока на двух кучах: в левой — меньшая половина,
+ * в правой — большая. Добавление O(log n), медиана O(1).
  */
-double findMin(double* arr, int size) {
-    double min = arr[0];
-    for (int i = 1; i < size; ++i) if (min > arr[i]) min = arr[i];
-    return min;
+class StreamingMedian {
+    priority_queue<double> lower;
+    priority_queue<double, vector<double>, greater<double>> upper;
+
+public:
+    /*
+     * Добавляет значение.
+     * @param x новое значение.
+     */
+    void add(double x) {
+        if (lower.empty() || x <= lower.top()) lower.push(x);
+        else upper.push(x);
+        if (lower.size() > upper.size() + 1) {
+            upper.push(lower.top());
+            lower.pop();
+        }
+        else if (upper.size() > lower.size()) {
+            lower.push(upper.top());
+            upper.pop();
+        }
+    }
+
+    /* Текущая медиана (0 для пустого потока). */
+    double median() const {
+        if (lower.empty()) return 0;
+        if (lower.size() > upper.size()) return lower.top();
+        return (lower.top() + upper.top()) / 2.0;
+    }
+
+    /* Число значений. */
+    size_t size() const { return lower.size() + upper.size(); }
+};
+
+/*
+ * Приближённые квантили потока (t-digest со слиянием).
+ * Значения собираются в центроиды; у краёв распределения центроиды мельче,
+ * поэтому хвостовые перцентили (p99) точнее средних. Память O(compression).
+ */
+class TDigest {
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+    static constexpr double PI = 3.14159265358979323846;
+    double compression;
+    vector<Centroid> centroids;
+    vector<Centroid> buffer;
+    size_t bufferLimit;
+    double totalWeight = 0;
+    double minValue = 0;
+    double maxValue = 0;
+
+    /* Шкала k1: k(q) = compression / (2π) · asin(2q - 1). */
+    double qToK(double q) const { return compression / (2 * PI) * asin(2 * q - 1); }
+    double kToQ(double k) const { return (sin(k * 2 * PI / compression) + 1) / 2; }
+
+    /* Вливает накопленный буфер в центроиды. */
+    void flush() {
+        if (buffer.empty()) return;
+        for (const Centroid& c : buffer) totalWeight += c.weight;
+        buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+        sort(buffer.begin(), buffer.end(), [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+        centroids.clear();
+        Centroid cur = buffer[0];
+        double weightSoFar = 0;
+        double qLimit = kToQ(qToK(0) + 1);
+        for (size_t i = 1; i < buffer.size(); ++i) {
+            const Centroid& next = buffer[i];
+            double q = (weightSoFar + cur.weight + next.weight) / totalWeight;
+            if (q <= qLimit) {
+                cur.mean += (next.mean - cur.mean) * next.weight / (cur.weight + next.weight);
+                cur.weight += next.weight;
+            }
+            else {
+                weightSoFar += cur.weight;
+                centroids.push_back(cur);
+                qLimit = kToQ(qToK(weightSoFar / totalWeight) + 1);
+                cur = next;
+            }
+        }
+        centroids.push_back(cur);
+        buffer.clear();
+    }
+
+public:
+    /*
+     * Конструктор.
+     * @param delta степень сжатия: больше — точнее и больше памяти.
+     */
+    explicit TDigest(double delta = 100)
+        : compression(delta > 10 ? delta : 10), bufferLimit(size_t(compression) * 5) {
+        buffer.reserve(bufferLimit);
+    }
+
+    /*
+     * Добавляет значение.
+     * @param x новое значение.
+     */
+    void add(double x) {
+        if (totalWeight == 0 && buffer.empty()) minValue = maxValue = x;
+        minValue = min(minValue, x);
+        maxValue = max(maxValue, x);
+        buffer.push_back(Centroid{ x, 1 });
+        if (buffer.size() >= bufferLimit) flush();
+    }
+
+    /*
+     * Оценка квантиля.
+     * @param q доля от 0 до 1.
+     */
+    double quantile(double q) {
+        flush();
+        if (centroids.empty()) return 0;
+        if (centroids.size() == 1) return centroids[0].mean;
+        q = min(max(q, 0.0), 1.0);
+        double target = q * totalWeight;
+        // Центр i-го центроида находится на накопленном весе cumulative + weight / 2.
+        double cumulative = 0;
+        double prevCenter = 0, prevMean = minValue;
+        for (const Centroid& c : centroids) {
+            double center = cumulative + c.weight / 2;
+            if (target < center) {
+                double t = center > prevCenter ? (target - prevCenter) / (center - prevCenter) : 0;
+                return prevMean + t * (c.mean - prevMean);
+            }
+            prevCenter = center;
+            prevMean = c.mean;
+            cumulative += c.weight;
+        }
+        double t = totalWeight > prevCenter ? (target - prevCenter) / (totalWeight - prevCenter) : 0;
+        return prevMean + t * (maxValue - prevMean);
+    }
+
+    /* Число центроидов (размер сводки). */
+    size_t size() const { return centroids.size() + buffer.size(); }
+};
+
+/*
+ * Число младших нулевых битов (x != 0)
+ */
+inline int countTrailingZeros(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return int(index);
+#else
+    return __builtin_ctzll(x);
+#endif
 }
 
 /*
- * Вычисление среднего арифметического
+ * Индекс для пакетных запросов к отсортированному массиву.
+ * Ключи дополнительно хранятся в порядке Эйтцингера (дерево поиска в массиве:
+ * дети узла k — 2k и 2k+1), поэтому первые уровни поиска лежат рядом в кэше,
+ * а спуск идёт без ветвлений с предвыборкой на несколько уровней вперёд.
+ */
+class SortedQueryIndex {
+    const double* sorted;
+    size_t n;
+    vector<double> eytzinger;
+    vector<size_t> rankOf;
+
+    /* Раскладывает отсортированный массив по узлам дерева обходом in-order. */
+    size_t build(size_t i, size_t k) {
+        if (k <= n) {
+            i = build(i, 2 * k);
+            eytzinger[k] = sorted[i];
+            rankOf[k] = i++;
+            i = build(i, 2 * k + 1);
+        }
+        return i;
+    }
+
+    /*
+     * Спуск по дереву: в каждом узле идём вправо, если ключ «меньше» x.
+     * @return индекс в отсортированном массиве первого ключа, не прошедшего проверку.
+     */
+    template <bool Upper>
+    size_t search(double x) const {
+        const double* e = eytzinger.data();
+        size_t k = 1;
+        while (k <= n) {
+#if defined(_MSC_VER)
+            _mm_prefetch((const char*)(e + 8 * k), _MM_HINT_T0);
+#else
+            __builtin_prefetch(e + 8 * k);
+#endif
+            k = 2 * k + (Upper ? e[k] <= x : e[k] < x);
+        }
+        // Снимаем хвост из единиц (шаги вправо) и последний шаг влево.
+        k >>= countTrailingZeros(~uint64_t(k)) + 1;
+        return k == 0 ? n : rankOf[k];
+    }
+
+public:
+    /*
+     * Строит индекс.
+     * @param arr отсортированный по возрастанию массив (должен жить дольше индекса).
+     * @param size размер массива.
+     */
+    SortedQueryIndex(const double* arr, size_t size)
+        : sorted(arr), n(size), eytzinger(size + 1), rankOf(size + 1) {
+        build(0, 1);
+    }
+
+    /* Индекс первого элемента, не меньшего x. */
+    size_t lowerBound(double x) const { return search<false>(x); }
+
+    /* Индекс первого элемента, большего x. */
+    size_t upperBound(double x) const { return search<true>(x); }
+
+    /*
+     * Сколько элементов лежит в отрезке [a, b].
+     */
+    size_t countInRange(double a, double b) const {
+        if (b < a) return 0;
+        return upperBound(b) - lowerBound(a);
+    }
+
+    /*
+     * Перцентиль с линейной интерполяцией, как у median, за O(1).
+     * @param p доля от 0 до 1.
+     */
+    double quantile(double p) const {
+        if (n == 0) return 0;
+        double h = (n - 1) * min(max(p, 0.0), 1.0);
+        size_t lo = size_t(h);
+        return lo + 1 < n ? sorted[lo] + (h - double(lo)) * (sorted[lo + 1] - sorted[lo]) : sorted[lo];
+    }
+
+    /*
+     * Пакет запросов «сколько значений в [a, b]», разделённый между потоками.
+     *
+     * @param ranges отрезки.
+     * @param threads число потоков, 0 — по числу ядер.
+     * @return возвращает ответы в порядке запросов.
+     */
+    vector<size_t> countRanges(const vector<pair<double, double>>& ranges, unsigned threads) const {
+        vector<size_t> result(ranges.size());
+        runBatch(ranges.size(), threads, [&](size_t i) { result[i] = countInRange(ranges[i].first, ranges[i].second); });
+        return result;
+    }
+
+    /*
+     * Пакет запросов перцентилей.
+     *
+     * @param ps доли от 0 до 1.
+     * @param threads число потоков, 0 — по числу ядер.
+     * @return возвращает ответы в порядке запросов.
+     */
+    vector<double> quantiles(const vector<double>& ps, unsigned threads) const {
+        vector<double> result(ps.size());
+        runBatch(ps.size(), threads, [&](size_t i) { result[i] = quantile(ps[i]); });
+        return result;
+    }
+
+private:
+    /* Делит запросы на непрерывные куски по потокам. */
+    template <class Query>
+    static void runBatch(size_t count, unsigned threads, Query query) {
+        if (threads == 0) threads = thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        size_t maxThreads = count / 4096 + 1;
+        if (threads > maxThreads) threads = unsigned(maxThreads);
+        size_t slice = (count + threads - 1) / threads;
+        auto worker = [&](size_t begin) {
+            size_t end = min(count, begin + slice);
+            for (size_t i = begin; i < end; ++i) query(i);
+        };
+        vector<thread> pool;
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, size_t(t) * slice);
+        worker(0);
+        for (auto& th : pool) th.join();
+    }
+};
+
+/*
+ * Чтение файла double с двойной буферизацией: пока вызывающий обрабатывает
+ * один буфер, следующий читается в фоновом потоке.
+ */
+class BufferedDoubleReader {
+    ifstream in;
+    vector<double> current;
+    vector<double> next;
+    size_t pos = 0;
+    size_t len = 0;
+    future<size_t> pending;
+
+    /* Запускает фоновое чтение в next. */
+    void startRead() {
+        pending = async(launch::async, [this] {
+            in.read((char*)next.data(), streamsize(next.size() * sizeof(double)));
+            return size_t(in.gcount()) / sizeof(double);
+        });
+    }
+
+    /* Берёт прочитанный буфер и запускает чтение следующего. */
+    bool refill() {
+        if (!pending.valid()) return false;
+        len = pending.get();
+        swap(current, next);
+        pos = 0;
+        if (len == 0) return false;
+        if (in) startRead();
+        return true;
+    }
+
+public:
+    /*
+     * Открывает файл.
+     * @param path путь к файлу.
+     * @param bufferElements размер каждого из двух буферов в элементах.
+     */
+    BufferedDoubleReader(const string& path, size_t bufferElements)
+        : in(path, ios::binary), current(bufferElements ? bufferElements : 1), next(current.size()) {
+        if (in) startRead();
+    }
+
+    ~BufferedDoubleReader() {
+        if (pending.valid()) pending.wait();
+    }
+
+    /* Открылся ли файл. */
+    bool isOpen() const { return in.is_open(); }
+
+    /*
+     * Читает следующее значение.
+     * @return false, если файл закончился.
+     */
+    bool read(double& x) {
+        if (pos == len && !refill()) return false;
+        x = current[pos++];
+        return true;
+    }
+};
+
+/*
+ * Запись файла double с двойной буферизацией: заполненный буфер пишется
+ * в фоновом потоке, пока заполняется второй.
+ */
+class BufferedDoubleWriter {
+    ofstream out;
+    vector<double> current;
+    vector<double> flushing;
+    size_t len = 0;
+    future<void> pending;
+
+    void startWrite() {
+        if (pending.valid()) pending.get();
+        swap(current, flushing);
+        size_t count = len;
+        len = 0;
+        pending = async(launch::async, [this, count] {
+            out.write((const char*)flushing.data(), streamsize(count * sizeof(double)));
+        });
+    }
+
+public:
+    /*
+     * Создаёт файл.
+     * @param path путь к файлу.
+     * @param bufferElements размер каждого из двух буферов в элементах.
+     */
+    BufferedDoubleWriter(const string& path, size_t bufferElements)
+        : out(path, ios::binary | ios::trunc), current(bufferElements ? bufferElements : 1), flushing(current.size()) {}
+
+    ~BufferedDoubleWriter() { close(); }
+
+    /* Открылся ли файл. */
+    bool isOpen() const { return out.is_open(); }
+
+    /* Добавляет значение. */
+    void write(double x) {
+        current[len++] = x;
+        if (len == current.size()) startWrite();
+    }
+
+    /*
+     * Дописывает остаток и закрывает файл.
+     * @return false при ошибке записи.
+     */
+    bool close() {
+        if (!out.is_open()) return false;
+        if (len > 0) startWrite();
+        if (pending.valid()) pending.get();
+        bool ok = bool(out);
+        out.close();
+        return ok;
+    }
+};
+
+/*
+ * Дерево проигравших для слияния k отсортированных потоков.
+ * Во внутренних узлах лежат проигравшие, победитель — в tree[0]; после выдачи
+ * минимума переигрывается только путь от его листа к корню: log2(k) сравнений.
+ */
+class LoserTree {
+    size_t k;
+    vector<size_t> tree;
+    vector<double> keys;
+    vector<bool> done;
+
+    bool less(size_t a, size_t b) const {
+        if (done[a]) return false;
+        if (done[b]) return true;
+        return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+    }
+
+    size_t build(size_t node) {
+        if (node >= k) return node - k;
+        size_t left = build(2 * node), right = build(2 * node + 1);
+        if (less(left, right)) { tree[node] = right; return left; }
+        tree[node] = left;
+        return right;
+    }
+
+public:
+    /*
+     * @param sources число потоков.
+     */
+    explicit LoserTree(size_t sources) : k(sources), tree(sources), keys(sources), done(sources, true) {}
+
+    /* Задаёт первое значение потока i (или отмечает его пустым) до вызова start. */
+    void set(size_t i, bool has, double key) { done[i] = !has; keys[i] = key; }
+
+    /* Разыгрывает начальное дерево. */
+    void start() { tree[0] = build(1); }
+
+    /* Есть ли ещё значения. */
+    bool empty() const { return done[tree[0]]; }
+
+    /* Номер потока с минимальным значением и само значение. */
+    size_t winner() const { return tree[0]; }
+    double top() const { return keys[tree[0]]; }
+
+    /*
+     * Заменяет значение победителя следующим из его потока и переигрывает путь.
+     * @param has есть ли у потока следующее значение.
+     */
+    void replaceTop(bool has, double key) {
+        size_t w = tree[0];
+        done[w] = !has;
+        keys[w] = key;
+        for (size_t node = (w + k) / 2; node > 0; node /= 2) {
+            if (less(tree[node], w)) swap(tree[node], w);
+        }
+        tree[0] = w;
+    }
+};
+
+/*
+ * Сливает отсортированные файлы в один
+ */
+bool mergeRuns(const vector<string>& runs, const string& output, size_t bufferElements) {
+    vector<unique_ptr<BufferedDoubleReader>> readers;
+    LoserTree tree(runs.size());
+    for (size_t i = 0; i < runs.size(); ++i) {
+        readers.emplace_back(new BufferedDoubleReader(runs[i], bufferElements));
+        if (!readers[i]->isOpen()) return false;
+        double x = 0;
+        bool has = readers[i]->read(x);
+        tree.set(i, has, x);
+    }
+    tree.start();
+    BufferedDoubleWriter writer(output, bufferElements);
+    if (!writer.isOpen()) return false;
+    while (!tree.empty()) {
+        writer.write(tree.top());
+        double x = 0;
+        bool has = readers[tree.winner()]->read(x);
+        tree.replaceTop(has, x);
+    }
+    return writer.close();
+}
+
+/*
+ * Сортировка двоичного файла double, который не помещается в память.
+ * Файл читается частями по половине бюджета; каждая часть сортируется
+ * (пока следующая читается, а предыдущая пишется в фоне) и сохраняется
+ * во временный файл. Затем файлы сливаются деревом проигравших; если их
+ * слишком много для бюджета, слияние идёт в несколько проходов.
  *
- * @param arr указатель на массив.
- * @param size размер массива.
- * @return среднее значение.
+ * @param input путь к исходному файлу.
+ * @param output путь к результату.
+ * @param memoryBudget бюджет памяти в байтах.
+ * @param threads число потоков сортировки частей, 0 — по числу ядер.
+ * @return возвращает false при ошибке ввода-вывода.
  */
-double avg(double* arr, int size) {
-    double sum = 0;
-    for (int i = 0; i < size; ++i) sum += arr[i];
-    return sum / size;
+bool externalSort(const string& input, const string& output, size_t memoryBudget, unsigned threads) {
+    const size_t minBuffer = 4096;
+    size_t budgetElements = max(memoryBudget / sizeof(double), 4 * minBuffer);
+    size_t runElements = budgetElements / 2;
+
+    ifstream in(input, ios::binary);
+    if (!in) return false;
+
+    vector<string> runs;
+    vector<double> chunks[2] = { vector<double>(runElements), vector<double>(runElements) };
+    future<size_t> reading;
+    future<bool> writing[2];
+    auto readChunk = [&in, runElements](vector<double>* chunk) {
+        in.read((char*)chunk->data(), streamsize(runElements * sizeof(double)));
+        return size_t(in.gcount()) / sizeof(double);
+    };
+    auto writeRun = [](string path, const vector<double>* chunk, size_t count) {
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write((const char*)chunk->data(), streamsize(count * sizeof(double)));
+        return bool(out);
+    };
+
+    int cur = 0;
+    reading = async(launch::async, readChunk, &chunks[cur]);
+    bool ok = true;
+    while (true) {
+        size_t count = reading.get();
+        if (count == 0) break;
+        // Второй буфер может ещё записываться — дожидаемся, прежде чем читать в него.
+        if (writing[1 - cur].valid()) ok &= writing[1 - cur].get();
+        if (in) reading = async(launch::async, readChunk, &chunks[1 - cur]);
+        sortirovkaParallel(chunks[cur].data(), count, threads);
+        runs.push_back(output + ".run" + to_string(runs.size()));
+        writing[cur] = async(launch::async, writeRun, runs.back(), &chunks[cur], count);
+        if (!reading.valid()) break;
+        cur = 1 - cur;
+    }
+    for (auto& w : writing) {
+        if (w.valid()) ok &= w.get();
+    }
+    in.close();
+    for (auto& c : chunks) vector<double>().swap(c);
+    if (!ok) return false;
+
+    if (runs.empty()) return bool(ofstream(output, ios::binary | ios::trunc));
+
+    // На каждый вход и на выход по два буфера.
+    size_t maxFanIn = max(size_t(2), budgetElements / (2 * minBuffer) - 1);
+    size_t generation = 0;
+    while (runs.size() > 1) {
+        vector<string> merged;
+        for (size_t begin = 0; begin < runs.size(); begin += maxFanIn) {
+            size_t end = min(runs.size(), begin + maxFanIn);
+            vector<string> group(runs.begin() + begin, runs.begin() + end);
+            size_t buffer = budgetElements / (2 * (group.size() + 1));
+            bool last = runs.size() <= maxFanIn;
+            string target = last ? output : output + ".merge" + to_string(generation) + "_" + to_string(merged.size());
+            if (!mergeRuns(group, target, buffer)) return false;
+            for (const string& r : group) remove(r.c_str());
+            merged.push_back(target);
+        }
+        runs.swap(merged);
+        ++generation;
+    }
+    if (runs[0] != output) {
+        remove(output.c_str());
+        if (rename(runs[0].c_str(), output.c_str()) != 0) return false;
+    }
+    return true;
 }
 
 /*
- * Вычисление медианы
+ * Статистика отсортированного файла за один потоковый проход:
+ * минимум и максимум — первый и последний элементы, среднее — компенсированной
+ * суммой, медиана — по известному из размера файла индексу.
  *
- * @param arr указатель на массив.
- * @param size размер массива.
- * @return медианное значение.
+ * @param path путь к отсортированному файлу.
+ * @param stats результат: min, max, sum, sumSq, count.
+ * @param med медиана.
+ * @return возвращает false, если файл не открылся.
  */
-double median(double* arr, int size) {
-    return (size % 2 != 0) ? arr[(size - 1) / 2] : (arr[size / 2 - 1] + arr[size / 2]) / 2.0;
+bool sortedFileStats(const string& path, ArrayStats& stats, double& med) {
+    ifstream probe(path, ios::binary | ios::ate);
+    if (!probe) return false;
+    size_t count = size_t(probe.tellg()) / sizeof(double);
+    probe.close();
+
+    BufferedDoubleReader reader(path, size_t(1) << 20);
+    KahanSum sum, sumSq;
+    stats = ArrayStats();
+    med = 0;
+    double x, lower = 0;
+    size_t i = 0;
+    while (reader.read(x)) {
+        if (i == 0) stats.min = x;
+        stats.max = x;
+        sum.add(x);
+        sumSq.add(x * x);
+        if (count % 2 == 0 && count > 0 && i == count / 2 - 1) lower = x;
+        if (i == count / 2) med = count % 2 != 0 ? x : (lower + x) / 2.0;
+        ++i;
+    }
+    stats.sum = sum.value();
+    stats.sumSq = sumSq.value();
+    stats.count = i;
+    return true;
 }
 
 /*
@@ -115,12 +2224,10 @@ double median(double* arr, int size) {
  *
  * @param arr указатель на массив.
  * @param size размер массива.
- * @return указатель на новый массив.
+ * @return новый массив.
  */
-double* newArray(double* arr, int size) {
-    double* arr2 = new double[size];
-    for (int i = 0; i < size; ++i) arr2[i] = arr[i] * i;
-    return arr2;
+DoubleArray newArray(const double* arr, size_t size) {
+    return materialize(view(arr, size) * index());
 }
 
 /*
@@ -129,7 +2236,7 @@ double* newArray(double* arr, int size) {
  * @param arr ссылка на массив из 5 элементов.
  */
 void arrayReference(double(&arr)[5]) {
-    for (int i = 0; i < 5; ++i) arr[i] += 100;
+    evaluate(view(arr, 5) + 100, 0, 5, arr);
 }
 
 /*
@@ -138,33 +2245,43 @@ void arrayReference(double(&arr)[5]) {
  * @param arr указатель на массив.
  * @param size размер массива.
  */
-void arrayPointer(double* arr, int size) {
-    for (int i = 0; i < size; ++i) arr[i] += 100;
+void arrayPointer(double* arr, size_t size) {
+    evaluate(view(arr, size) + 100, 0, size, arr);
 }
 
 /*
  * Вывод максимума и минимума
  */
-void action1(double* arr, int n) {
-    cout << "Max: " << findMax(arr, n) << " | Min: " << findMin(arr, n) << endl;
+void action1(const DoubleArray& arr) {
+    // Массив отсортирован в main, поэтому максимум и минимум лежат на концах.
+    double min, max;
+    findMinMax(arr.data(), arr.size(), true, min, max);
+    cout << "Max: " << max << " | Min: " << min << endl;
 }
 
 /*
  * Среднее арифметическое и медиана
  */
-void action2(double* arr, int n) {
-    cout << "Среднее арифметическое: " << avg(arr, n) << endl;
-    cout << "Медиана: " << median(arr, n) << endl;
+void action2(const DoubleArray& arr) {
+    ArrayStats stats = reduceStats(arr.data(), arr.size(), 0, true);
+    cout << "Среднее арифметическое: " << stats.mean() << endl;
+    cout << "Стандартное отклонение: " << sqrt(stats.variance() > 0 ? stats.variance() : 0) << endl;
+    cout << "Медиана: " << median(arr.data(), arr.size()) << endl;
 }
 
 /*
  * Создание нового массива и вывод
  */
-void action3(double* arr, int n) {
-    double* arr2 = newArray(arr, n);
-    cout << "Новый массив:\n";
-    printArray(arr2, n);
-    delete[] arr2;
+void action3(const DoubleArray& arr, bool printValues = true) {
+    // Новый массив не создаётся: значения считаются на лету при выводе и свёртке.
+    auto scaled = view(arr) * index();
+    if (printValues) {
+        cout << "Новый массив:\n";
+        printArray(scaled);
+    }
+    ArrayStats stats = reduceStats(scaled);
+    cout << "Max: " << stats.max << " | Min: " << stats.min << endl;
+    cout << "Среднее арифметическое: " << stats.mean() << endl;
 }
 
 /*
@@ -183,6 +2300,109 @@ void action4() {
     printArray(arrRef, 5);
 }
 
+/*
+ * Время параллельных сортировок копии массива на 1–32 потоках
+ */
+void action5(const DoubleArray& arr) {
+    size_t n = arr.size();
+    DoubleArray copyArr(n);
+    if (!copyArr.isOpen()) return;
+    auto measure = [&](void (*sortFn)(double*, size_t, unsigned), unsigned threads) {
+        copy(arr.begin(), arr.end(), copyArr.begin());
+        // Массив уже отсортирован, поэтому перемешиваем его одинаково для всех запусков.
+        for (size_t i = n; i > 1; --i) swap(copyArr[i - 1], copyArr[((i - 1) * 2654435761u) % i]);
+        auto start = chrono::steady_clock::now();
+        sortFn(copyArr.data(), copyArr.size(), threads);
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+    printf("Потоков | quicksort, мс | ускорение | mergesort, мс | ускорение\n");
+    double baseQuick = 0, baseMerge = 0;
+    for (unsigned threads = 1; threads <= 32; threads *= 2) {
+        double quickMs = measure(sortirovkaParallel, threads);
+        double mergeMs = measure(mergeSortParallel, threads);
+        if (threads == 1) { baseQuick = quickMs; baseMerge = mergeMs; }
+        printf("%7u | %13.1f | %9.2f | %13.1f | %9.2f\n", threads, quickMs, baseQuick / quickMs, mergeMs, baseMerge / mergeMs);
+    }
+}
+
+/*
+ * Медиана и перцентили без полной сортировки, точные и потоковые
+ */
+void action6(const DoubleArray& arr) {
+    if (arr.size() == 0) return;
+    vector<double> copyArr(arr.begin(), arr.end());
+    vector<double> ps = { 0.5, 0.9, 0.99 };
+    vector<double> exact = percentilesSelect(copyArr.data(), copyArr.size(), ps);
+
+    StreamingMedian streaming;
+    TDigest digest;
+    for (double x : arr) {
+        streaming.add(x);
+        digest.add(x);
+    }
+    cout << "Медиана (выбор): " << medianSelect(copyArr.data(), copyArr.size()) << endl;
+    cout << "Медиана (поток): " << streaming.median() << endl;
+    for (size_t q = 0; q < ps.size(); ++q) {
+        cout << "p" << ps[q] * 100 << ": " << exact[q] << " | t-digest: " << digest.quantile(ps[q]) << endl;
+    }
+}
+
+/*
+ * Пакет случайных запросов по диапазонам и перцентилям к отсортированному массиву
+ */
+void action7(const DoubleArray& arr) {
+    if (arr.size() == 0) return;
+    SortedQueryIndex index(arr.data(), arr.size());
+    const size_t queries = 1000000;
+    vector<pair<double, double>> ranges(queries);
+    uint64_t state = 12345;
+    for (auto& r : ranges) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        double a = 20 + (state >> 11) * (19980.0 / 9007199254740992.0);
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        double b = a + (state >> 11) * (2000.0 / 9007199254740992.0);
+        r = { a, b };
+    }
+    auto start = chrono::steady_clock::now();
+    vector<size_t> counts = index.countRanges(ranges, 0);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    vector<double> q = index.quantiles({ 0.5, 0.9, 0.99 }, 1);
+
+    printf("p50: %f | p90: %f | p99: %f\n", q[0], q[1], q[2]);
+    for (size_t i = 0; i < 3; ++i) {
+        printf("[%f, %f]: %zu\n", ranges[i].first, ranges[i].second, counts[i]);
+    }
+    printf("%zu запросов за %.1f мс (%.1f млн/с)\n", queries, ms, queries / ms / 1000);
+}
+
+/*
+ * Внешняя сортировка двоичного файла double и статистика по результату
+ */
+void action8() {
+    string input, output;
+    size_t budgetMb;
+    cout << "Исходный файл: ";
+    cin >> input;
+    cout << "Файл результата: ";
+    cin >> output;
+    cout << "Бюджет памяти, МБ: ";
+    cin >> budgetMb;
+
+    auto start = chrono::steady_clock::now();
+    if (!externalSort(input, output, budgetMb << 20, 0)) {
+        cout << "Ошибка сортировки файла.\n";
+        return;
+    }
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    ArrayStats stats;
+    double med;
+    sortedFileStats(output, stats, med);
+    cout << "Отсортировано " << stats.count << " чисел за " << sec << " с\n";
+    cout << "Max: " << stats.max << " | Min: " << stats.min << endl;
+    cout << "Среднее арифметическое: " << stats.mean() << endl;
+    cout << "Медиана: " << med << endl;
+}
+
 /*
  * Меню выбора действия
  */
@@ -192,39 +2412,366 @@ void menu() {
     cout << "2. Вычислить среднее арифметическое и медиану.\n";
     cout << "3. Создать новый массив, содержащий частоты, умноженные на коэффициент.\n";
     cout << "4. Сравнить передачу массива в функцию по ссылке и по указателю.\n";
+    cout << "5. Измерить масштабирование параллельной сортировки.\n";
+    cout << "6. Медиана и перцентили без полной сортировки.\n";
+    cout << "7. Пакет запросов по диапазонам частот и перцентилям.\n";
+    cout << "8. Отсортировать файл, не помещающийся в память.\n";
+}
+
+/*
+ * Число с подсчётом операций сортировки: сравнений, обменов и прочих
+ * перемещений элементов. Счётчики общие, поэтому считать можно только
+ * однопоточные сортировки.
+ */
+struct CountedDouble {
+    double value;
+
+    static inline uint64_t comparisons = 0;
+    static inline uint64_t swaps = 0;
+    static inline uint64_t moves = 0;
+
+    static void reset() { comparisons = swaps = moves = 0; }
+
+    CountedDouble() : value(0) {}
+    CountedDouble(const CountedDouble& other) : value(other.value) { ++moves; }
+    CountedDouble& operator=(const CountedDouble& other) {
+        value = other.value;
+        ++moves;
+        return *this;
+    }
+    bool operator<(const CountedDouble& other) const {
+        ++comparisons;
+        return value < other.value;
+    }
+};
+
+inline void swap(CountedDouble& a, CountedDouble& b) {
+    std::swap(a.value, b.value);
+    ++CountedDouble::swaps;
+}
+
+/*
+ * Распределения входных данных для замеров.
+ */
+enum Distribution { Uniform, Sorted, Reversed, OrganPipe, FewUnique, ManyDuplicates, DistributionCount };
+
+const char* const DISTRIBUTION_NAMES[DistributionCount] = {
+    "uniform", "sorted", "reversed", "organ_pipe", "few_unique", "many_duplicates"
+};
+
+/*
+ * Заполняет массив по распределению
+ *
+ * @param arr указатель на массив.
+ * @param size размер массива.
+ * @param dist распределение.
+ * @param seed зерно генератора.
+ */
+void fillDistribution(double* arr, size_t size, Distribution dist, uint64_t seed) {
+    fillArray(arr, size, seed);
+    switch (dist) {
+    case Uniform: break;
+    case Sorted: sortirovkaParallel(arr, size, 0); break;
+    case Reversed:
+        sortirovkaParallel(arr, size, 0);
+        reverse(arr, arr + size);
+        break;
+    case OrganPipe:
+        // Возрастание до середины, затем убывание.
+        for (size_t i = 0; i < size; ++i) arr[i] = double(i < size / 2 ? i : size - 1 - i);
+        break;
+    case FewUnique:
+        for (size_t i = 0; i < size; ++i) arr[i] = floor(arr[i] / 2500) * 2500;
+        break;
+    case ManyDuplicates:
+        // Частоты с точностью до 1 Гц: около 20 тысяч разных значений.
+        for (size_t i = 0; i < size; ++i) arr[i] = floor(arr[i]);
+        break;
+    default: break;
+    }
+}
+
+/*
+ * Пиковый объём резидентной памяти процесса в КиБ.
+ */
+size_t peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return size_t(usage.ru_maxrss) / 1024;
+#else
+    return size_t(usage.ru_maxrss);
+#endif
+#endif
+}
+
+/*
+ * Одна строка результата замера. Счётчики -1, если ядро их не считает.
+ */
+struct BenchResult {
+    const char* kernel;
+    const char* distribution;
+    size_t size;
+    double nsPerElement;
+    long long comparisons;
+    long long swaps;
+    long long moves;
+    size_t peakRssKb;
+};
+
+/*
+ * Выводит строку результата в CSV или JSON Lines
+ */
+void printBenchResult(const BenchResult& r, bool json) {
+    if (json) {
+        printf("{\"kernel\":\"%s\",\"distribution\":\"%s\",\"n\":%zu,\"ns_per_element\":%.4f,"
+            "\"comparisons\":%lld,\"swaps\":%lld,\"moves\":%lld,\"peak_rss_kb\":%zu}\n",
+            r.kernel, r.distribution, r.size, r.nsPerElement, r.comparisons, r.swaps, r.moves, r.peakRssKb);
+    } else {
+        printf("%s,%s,%zu,%.4f,%lld,%lld,%lld,%zu\n", r.kernel, r.distribution, r.size, r.nsPerElement,
+            r.comparisons, r.swaps, r.moves, r.peakRssKb);
+    }
+    fflush(stdout);
+}
+
+/*
+ * Проверка, что заполнение и свёртка не зависят от числа потоков: на
+ * размерах у границ частей массив и итоги при 1 и нескольких потоках должны
+ * совпадать побитово. Последний элемент при свёртке — заметный выброс,
+ * чтобы потерянный хвост был виден.
+ *
+ * @return возвращает false и печатает расхождение, если результаты разошлись.
+ */
+bool checkThreadCounts() {
+    const size_t sizes[] = { 1, REDUCE_CHUNK - 1, REDUCE_CHUNK, 2 * REDUCE_CHUNK + 1, 3 * REDUCE_CHUNK + 5, 1000003 };
+    const unsigned threadCounts[] = { 2, 3, 4, 8, 0 };
+    for (size_t n : sizes) {
+        vector<double> arr(n), filled(n);
+        fillArray(arr.data(), n, 42, 1);
+        for (unsigned threads : threadCounts) {
+            // Заполненный заранее мусор не должен пережить fillArray.
+            fill(filled.begin(), filled.end(), -1.0);
+            fillArray(filled.data(), n, 42, threads);
+            if (memcmp(filled.data(), arr.data(), n * sizeof(double)) != 0) {
+                fprintf(stderr, "fillArray: n = %zu, потоков %u: массив отличается от однопоточного\n", n, threads);
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) arr[i] = double(i % 7) + 1;
+        arr[n - 1] = 1e6;
+        ArrayStats base = reduceStats(arr.data(), n, 1);
+        for (unsigned threads : threadCounts) {
+            ArrayStats stats = reduceStats(arr.data(), n, threads);
+            if (memcmp(&stats.min, &base.min, sizeof(double)) != 0 || memcmp(&stats.max, &base.max, sizeof(double)) != 0
+                || memcmp(&stats.sum, &base.sum, sizeof(double)) != 0 || memcmp(&stats.sumSq, &base.sumSq, sizeof(double)) != 0
+                || stats.count != base.count) {
+                fprintf(stderr, "reduceStats: n = %zu, потоков %u: сумма %.17g вместо %.17g, максимум %g вместо %g\n",
+                    n, threads, stats.sum, base.sum, stats.max, base.max);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Наибольший размер, на котором считаются операции: копия из CountedDouble
+ * и сортировка с подсчётом заметно медленнее обычной.
+ */
+const size_t COUNT_LIMIT = size_t(10000000);
+
+/*
+ * Замеры сортировок и статистик на разных распределениях:
+ * ConsoleApplication1 --bench [мин. степень 10] [макс. степень 10] [csv|json] [потоков]
+ * Размеры — 10^мин..10^макс (по умолчанию 3..7, до 9). Время — лучшее из
+ * нескольких повторов, чтобы на малых размерах общий замер длился не меньше
+ * ~10^7 элементов. Пиковая память — максимум процесса к моменту строки.
+ * Перед замерами проверяется, что итоги не зависят от числа потоков.
+ */
+int runBenchmark(int argc, char* argv[]) {
+    int minExp = argc > 2 ? atoi(argv[2]) : 3;
+    int maxExp = argc > 3 ? atoi(argv[3]) : 7;
+    bool json = argc > 4 && strcmp(argv[4], "json") == 0;
+    unsigned threads = argc > 5 ? unsigned(atoi(argv[5])) : 0;
+    if (minExp < 0 || maxExp > 18 || minExp > maxExp) {
+        fprintf(stderr, "Использование: ConsoleApplication1 --bench [мин. степень] [макс. степень] [csv|json] [потоков]\n");
+        return 1;
+    }
+    if (!checkThreadCounts()) return 1;
+    if (!json) printf("kernel,distribution,n,ns_per_element,comparisons,swaps,moves,peak_rss_kb\n");
+
+    struct Kernel {
+        const char* name;
+        function<void(double*, size_t)> run;
+    };
+    volatile double sink = 0;
+    vector<Kernel> kernels = {
+        { "sortirovka", [](double* a, size_t n) { sortirovka(a, n); } },
+        { "sortirovka_parallel", [threads](double* a, size_t n) { sortirovkaParallel(a, n, threads); } },
+        { "merge_sort_parallel", [threads](double* a, size_t n) { mergeSortParallel(a, n, threads); } },
+        { "radix_sort", [](double* a, size_t n) { radixSort(a, n); } },
+        { "std_sort", [](double* a, size_t n) { sort(a, a + n); } },
+        { "reduce_stats", [threads, &sink](double* a, size_t n) { sink = sink + reduceStats(a, n, threads).mean(); } },
+        { "max_min_avg", [&sink](double* a, size_t n) { sink = sink + findMax(a, n) + findMin(a, n) + avg(a, n); } },
+        { "median_select", [&sink](double* a, size_t n) { sink = sink + medianSelect(a, n); } },
+    };
+
+    for (int e = minExp; e <= maxExp; ++e) {
+        size_t n = 1;
+        for (int k = 0; k < e; ++k) n *= 10;
+        DoubleArray source(n), work(n);
+        if (!source.isOpen() || !work.isOpen()) {
+            fprintf(stderr, "Не удалось выделить память для n = %zu\n", n);
+            return 1;
+        }
+        size_t reps = max(size_t(1), min(size_t(100), size_t(10000000) / n));
+        for (int d = 0; d < DistributionCount; ++d) {
+            fillDistribution(source.data(), n, Distribution(d), 12345);
+            for (const Kernel& kernel : kernels) {
+                double best = 0;
+                for (size_t r = 0; r < reps; ++r) {
+                    memcpy(work.data(), source.data(), n * sizeof(double));
+                    auto start = chrono::steady_clock::now();
+                    kernel.run(work.data(), n);
+                    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+                    if (r == 0 || ns < best) best = ns;
+                }
+                BenchResult result = { kernel.name, DISTRIBUTION_NAMES[d], n, best / double(n), -1, -1, -1, 0 };
+                if (strcmp(kernel.name, "sortirovka") == 0 && n <= COUNT_LIMIT) {
+                    vector<CountedDouble> counted(n);
+                    for (size_t i = 0; i < n; ++i) counted[i].value = source[i];
+                    CountedDouble::reset();
+                    sortirovka(counted.data(), n);
+                    result.comparisons = (long long)CountedDouble::comparisons;
+                    result.swaps = (long long)CountedDouble::swaps;
+                    result.moves = (long long)CountedDouble::moves;
+                }
+                result.peakRssKb = peakRssKb();
+                printBenchResult(result, json);
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Пакетный режим без меню и очистки экрана:
+ * ConsoleApplication1 --batch <N> <seed> <действия> [сортировка] [файл|-]
+ * Действия — номера пунктов меню подряд (например, 1267), выводятся только
+ * их результаты. Если задан файл, отсортированный массив записывается в него
+ * ("-" — в стандартный вывод).
+ */
+int runBatch(int argc, char* argv[]) {
+    if (argc < 5) {
+        fprintf(stderr, "Использование: ConsoleApplication1 --batch <N> <seed> <действия> [сортировка] [файл|-]\n");
+        return 1;
+    }
+    for (const char* c = argv[4]; *c; ++c) {
+        if ((*c < '1' || *c > '7') && *c != ',') {
+            fprintf(stderr, "Неизвестное действие: %c\n", *c);
+            return 1;
+        }
+    }
+    size_t n = size_t(strtoull(argv[2], nullptr, 10));
+    uint64_t seed = strtoull(argv[3], nullptr, 10);
+    int backend = argc > 5 ? atoi(argv[5]) : ParallelQuickSort;
+    if (backend < QuickSort || backend > RadixSort) backend = ParallelQuickSort;
+
+    DoubleArray arr(n);
+    if (!arr.isOpen()) {
+        fprintf(stderr, "Не удалось выделить память под массив.\n");
+        return 1;
+    }
+    fillArray(arr.data(), arr.size(), seed);
+    sortArray(arr.data(), arr.size(), SortBackend(backend));
+
+    if (argc > 6) {
+        bool ok;
+        if (strcmp(argv[6], "-") == 0) {
+            ok = writeArray(view(arr), cout);
+        } else {
+            ofstream out(argv[6], ios::binary);
+            ok = out && writeArray(view(arr), out);
+        }
+        if (!ok) {
+            fprintf(stderr, "Ошибка записи массива: %s\n", argv[6]);
+            return 1;
+        }
+    }
+
+    for (const char* c = argv[4]; *c; ++c) {
+        switch (*c) {
+        case '1': action1(arr); break;
+        case '2': action2(arr); break;
+        case '3': action3(arr, false); break;
+        case '4': action4(); break;
+        case '5': action5(arr); break;
+        case '6': action6(arr); break;
+        case '7': action7(arr); break;
+        default: break;
+        }
+    }
+    return 0;
 }
 
-int main() {
-    srand(time(NULL));
+int main(int argc, char* argv[]) {
     setlocale(LC_ALL, "RUS");
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) return runBatch(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) return runBenchmark(argc, argv);
 
-    int n;
+    size_t n;
     cout << "Значение N: ";
     cin >> n;
 
-    double* arr = new double[n];
-    fillArray(arr, n);
-    sortirovka(arr, 0, n - 1);
+    int backing;
+    string path;
+    cout << "Память (1 — обычная, 2 — большие страницы, 3 — файл): ";
+    cin >> backing;
+    if (backing == FileMapping) {
+        cout << "Файл массива: ";
+        cin >> path;
+    }
+
+    int backend;
+    cout << "Сортировка (1 — быстрая, 2 — параллельная, 3 — поразрядная): ";
+    cin >> backend;
+    if (backend < QuickSort || backend > RadixSort) backend = ParallelQuickSort;
+
+    DoubleArray arr(n, ArrayBacking(backing), path);
+    if (!arr.isOpen()) {
+        cout << "Не удалось выделить память под массив.\n";
+        return 1;
+    }
+    fillArray(arr.data(), arr.size(), uint64_t(time(NULL)));
+    sortArray(arr.data(), arr.size(), SortBackend(backend));
 
     int choice = 0;
     while (true) {
         system("cls");
         cout << "Исходный массив:\n";
-        printArray(arr, n);
+        printArray(arr.data(), arr.size());
         menu();
         cin >> choice;
 
         switch (choice) {
         case 0: exit(0);
-        case 1: action1(arr, n); break;
-        case 2: action2(arr, n); break;
-        case 3: action3(arr, n); break;
+        case 1: action1(arr); break;
+        case 2: action2(arr); break;
+        case 3: action3(arr); break;
         case 4: action4(); break;
+        case 5: action5(arr); break;
+        case 6: action6(arr); break;
+        case 7: action7(arr); break;
+        case 8: action8(); break;
         default: break;
         }
         cin.ignore();
         cin.get();
     }
-
-    delete[] arr;
 }
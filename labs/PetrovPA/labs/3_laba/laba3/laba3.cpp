@@ -2,6 +2,24 @@
 #include <vector>
 #include <map>
 #include <fstream> 
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <algorithm>
+#include <charconv>
+#include <thread>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
 struct Date {
@@ -19,17 +37,55 @@ struct MediaFile {
 };
 
 /**
- * Выводит на экран список медиафайлов.
+ * Стандартные типы медиафайлов. Код типа — один байт и номер
+ * в словаре типов каталога; эти четыре занимают коды 0–3.
+ */
+enum class MediaType : uint8_t { Audio, Video, Image, Document };
+
+const char* const MEDIA_TYPE_NAMES[] = { "Audio", "Video", "Image", "Document" };
+
+/**
+ * Наибольшее число разных типов в каталоге (код типа — один байт).
+ */
+const size_t MEDIA_TYPE_LIMIT = 256;
+
+/**
+ * Допустимые годы: дата упаковывается в 32 бита — 23 бита на год,
+ * 4 на месяц и 5 на день.
+ */
+const int MEDIA_YEAR_MIN = -(1 << 22);
+const int MEDIA_YEAR_MAX = (1 << 22) - 1;
+
+/**
+ * Помещается ли дата в 32 бита.
+ */
+bool isPackableDate(const Date& date) {
+	return date.day >= 1 && date.day <= 31 && date.month >= 1 && date.month <= 12
+		&& date.year >= MEDIA_YEAR_MIN && date.year <= MEDIA_YEAR_MAX;
+}
+
+/**
+ * Упаковывает дату в 32 бита так, что упакованные даты сравниваются
+ * как сами даты: год (со сдвигом к нулю), затем месяц, затем день.
  *
- * @param arr Вектор медиафайлов.
+ * @param date Дата (isPackableDate).
+ * @return Упакованная дата.
  */
-void printArr(vector<MediaFile> arr) {
-	for (auto media : arr) {
-		printf("\n\nId: %d \nИмя: %s \nПамять: %f \nТип: %s \nДата: %d.%d.%d ",
-			media.id, media.filename.c_str(), media.mb,
-			media.type.c_str(), media.creation_date.day, media.creation_date.month, media.creation_date.year);
-	}
+uint32_t packDate(const Date& date) {
+	return (uint32_t(date.year - MEDIA_YEAR_MIN) << 9) | (uint32_t(date.month) << 5) | uint32_t(date.day);
 }
+
+/**
+ * Распаковывает дату из 32 бит.
+ */
+Date unpackDate(uint32_t packed) {
+	Date date;
+	date.day = int(packed & 31);
+	date.month = int((packed >> 5) & 15);
+	date.year = int(packed >> 9) + MEDIA_YEAR_MIN;
+	return date;
+}
+
 /**
  * Генерирует случайную строку из строчных английских букв.
  *
@@ -69,8 +125,7 @@ double generateRandomDouble() {
  * @return Случайный тип медиафайла.
  */
 string randomGenerateType() {
-	string type[4] = { "Audio", "Video", "Image", "Document" };
-	return type[rand() % 4];
+	return MEDIA_TYPE_NAMES[rand() % 4];
 }
 
 /**
@@ -80,7 +135,7 @@ string randomGenerateType() {
  */
 Date randomGenerateDate() {
 	Date date;
-	date.year = rand();
+	date.year = rand() % (MEDIA_YEAR_MAX + 1);
 	date.month = rand() % 12 + 1;
 	map<int, int> days = {
 		{1, 31}, {2, 28}, {3, 31}, {4, 30}, {5, 31}, {6, 30},
@@ -103,6 +158,7 @@ Date randomGenerateDate() {
  */
 vector<MediaFile> randomGenerateMediaFile(int n) {
 	vector<MediaFile> vec;
+	vec.reserve(n > 0 ? size_t(n) : 0);
 	MediaFile med;
 	for (int i = 0; i < n; ++i) {
 		med.id = generateRandomInt();
@@ -115,35 +171,491 @@ vector<MediaFile> randomGenerateMediaFile(int n) {
 	return vec;
 }
 
+class MediaView;
+class MediaFileMap;
+
+/**
+ * Каталог медиафайлов — единственный владелец записей.
+ * Записи хранятся по столбцам: id, размер, код типа (один байт, названия —
+ * в словаре), упакованная в 32 бита дата и имена, лежащие подряд в одной
+ * строке-арене со столбцом смещений. Поиск, фильтрация и сортировка
+ * читают только нужные столбцы и возвращают выборки MediaView.
+ * Каталог, загруженный из двоичного файла, читает столбцы прямо из его
+ * отображения и копирует их к себе только при первом изменении.
+ */
+class MediaCatalog {
+	vector<int32_t> ids;
+	vector<double> mbs;
+	vector<uint8_t> types;
+	vector<uint32_t> dates;
+	string names;
+	vector<uint64_t> nameOffsets;
+	vector<string> typeNames;
+	map<string, uint8_t, less<>> typeCodes;
+
+	/** Столбцы отображённого файла, пока каталог читает из него. */
+	struct MappedColumns {
+		const int32_t* ids;
+		const double* mbs;
+		const uint8_t* types;
+		const uint32_t* dates;
+		const uint64_t* nameOffsets;
+		const char* names;
+		size_t count;
+		size_t nameBytes;
+	};
+	shared_ptr<const MediaFileMap> file;
+	MappedColumns mapped = {};
+
+	/**
+	 * Копирует столбцы отображения в свои векторы и отпускает файл.
+	 */
+	void detach() {
+		if (!file) return;
+		size_t n = mapped.count;
+		ids.assign(mapped.ids, mapped.ids + n);
+		mbs.assign(mapped.mbs, mapped.mbs + n);
+		types.assign(mapped.types, mapped.types + n);
+		dates.assign(mapped.dates, mapped.dates + n);
+		nameOffsets.assign(mapped.nameOffsets, mapped.nameOffsets + n + 1);
+		names.assign(mapped.names, mapped.nameBytes);
+		file.reset();
+		mapped = {};
+	}
+
+public:
+	MediaCatalog() : nameOffsets(1, 0) {
+		for (const char* name : MEDIA_TYPE_NAMES) internType(name);
+	}
+
+	/**
+	 * Раскладывает записи по столбцам.
+	 *
+	 * @param files Вектор медиафайлов.
+	 */
+	explicit MediaCatalog(const vector<MediaFile>& files) : MediaCatalog() {
+		size_t nameBytes = 0;
+		for (const MediaFile& media : files) nameBytes += media.filename.size();
+		reserve(files.size(), nameBytes);
+		for (const MediaFile& media : files) add(media);
+	}
+
+	/**
+	 * Резервирует место под записи.
+	 *
+	 * @param count Число записей.
+	 * @param nameBytes Суммарная длина имён.
+	 */
+	void reserve(size_t count, size_t nameBytes) {
+		ids.reserve(count);
+		mbs.reserve(count);
+		types.reserve(count);
+		dates.reserve(count);
+		nameOffsets.reserve(count + 1);
+		names.reserve(nameBytes);
+	}
+
+	/**
+	 * Код типа по названию; новое название добавляется в словарь.
+	 * Бросает length_error, если в словаре уже MEDIA_TYPE_LIMIT типов.
+	 */
+	uint8_t internType(string_view name) {
+		auto it = typeCodes.find(name);
+		if (it != typeCodes.end()) return it->second;
+		if (typeNames.size() >= MEDIA_TYPE_LIMIT) throw length_error("слишком много типов медиафайлов");
+		uint8_t code = uint8_t(typeNames.size());
+		typeNames.emplace_back(name);
+		typeCodes.emplace(typeNames.back(), code);
+		return code;
+	}
+
+	/**
+	 * Код типа по названию.
+	 *
+	 * @return Код или -1, если такого типа в каталоге нет.
+	 */
+	int findType(string_view name) const {
+		auto it = typeCodes.find(name);
+		return it == typeCodes.end() ? -1 : it->second;
+	}
+
+	/**
+	 * Добавляет запись. Бросает out_of_range, если дата не помещается в 32 бита.
+	 */
+	void add(const MediaFile& media) {
+		if (!isPackableDate(media.creation_date)) throw out_of_range("дата вне допустимого диапазона");
+		detach();
+		types.push_back(internType(media.type));
+		ids.push_back(media.id);
+		mbs.push_back(media.mb);
+		dates.push_back(packDate(media.creation_date));
+		names += media.filename;
+		nameOffsets.push_back(names.size());
+	}
+
+	/**
+	 * Делает каталог представлением двоичного файла: столбцы не копируются
+	 * и не разбираются, словарь типов берётся из файла. Проверяется только
+	 * то, что не требует прохода по записям; испорченные строки файла дают
+	 * пустые имена и неизвестный тип, но не выход за его границы.
+	 *
+	 * @param file Открытый двоичный файл.
+	 * @return false, если в файле слишком много или повторяющиеся типы.
+	 */
+	bool assign(shared_ptr<const MediaFileMap> file);
+
+	/** Число записей. */
+	size_t size() const { return file ? mapped.count : ids.size(); }
+	bool empty() const { return size() == 0; }
+	/** Число типов в словаре. */
+	size_t typeCount() const { return typeNames.size(); }
+	/** Название типа по коду; для кода вне словаря — "?". */
+	const string& typeName(uint8_t code) const {
+		static const string unknown = "?";
+		return code < typeNames.size() ? typeNames[code] : unknown;
+	}
+
+	/** Столбцы для сплошных проходов. */
+	const int32_t* idData() const { return file ? mapped.ids : ids.data(); }
+	const double* mbData() const { return file ? mapped.mbs : mbs.data(); }
+	const uint8_t* typeData() const { return file ? mapped.types : types.data(); }
+	const uint32_t* dateData() const { return file ? mapped.dates : dates.data(); }
+	/** Арена имён и смещения имён в ней (size() + 1). */
+	string_view nameArena() const { return file ? string_view(mapped.names, mapped.nameBytes) : string_view(names); }
+	const uint64_t* nameOffsetData() const { return file ? mapped.nameOffsets : nameOffsets.data(); }
+
+	int id(size_t i) const { return idData()[i]; }
+	double mb(size_t i) const { return mbData()[i]; }
+	uint8_t typeCode(size_t i) const { return typeData()[i]; }
+	const string& type(size_t i) const { return typeName(typeData()[i]); }
+	uint32_t packedDate(size_t i) const { return dateData()[i]; }
+	Date date(size_t i) const { return unpackDate(dateData()[i]); }
+	string_view filename(size_t i) const {
+		string_view arena = nameArena();
+		const uint64_t* offsets = nameOffsetData();
+		uint64_t begin = offsets[i], end = offsets[i + 1];
+		if (end > arena.size()) end = arena.size();
+		if (begin > end) begin = end;
+		return arena.substr(size_t(begin), size_t(end - begin));
+	}
+
+	/** Собирает i-ю запись. */
+	MediaFile get(size_t i) const {
+		MediaFile media;
+		media.id = id(i);
+		media.filename = string(filename(i));
+		media.mb = mb(i);
+		media.type = type(i);
+		media.creation_date = date(i);
+		return media;
+	}
+
+	/** Выборка из всех записей. */
+	MediaView all() const;
+
+	/** Переставляет записи каталога по дате (см. great). */
+	void sort();
+};
+
+/**
+ * Сравнивает две записи каталога по дате.
+ * Если даты совпадают — сравнение по имени.
+ *
+ * @param catalog Каталог.
+ * @param a Номер первой записи.
+ * @param b Номер второй записи.
+ * @return true, если a больше b, иначе false.
+ */
+bool great(const MediaCatalog& catalog, size_t a, size_t b) {
+	uint32_t dateA = catalog.packedDate(a), dateB = catalog.packedDate(b);
+	if (dateA != dateB) return dateA > dateB;
+	return catalog.filename(a) < catalog.filename(b);
+}
+
 /**
- * Фильтрует медиафайлы по типу и минимальному размеру.
+ * Сортировка номеров записей каталога.
+ * Переставляются только номера, сами записи остаются на месте.
  *
- * @param vec Вектор медиафайлов.
- * @param type Тип для фильтрации.
- * @param mb Минимальный размер.
- * @return Вектор медиафайлов, соответствующих условиям.
- */
-vector<MediaFile> filter(vector<MediaFile> vec, string type, int mb) {
-	vector<MediaFile> newVec;
-	for (int i = 0; i < vec.size(); ++i) {
-		if (vec[i].type == type && mb < vec[i].mb) {
-			newVec.push_back(vec[i]);
+ * @param catalog Каталог.
+ * @param rows Номера записей.
+ * @param left Левая граница.
+ * @param right Правая граница.
+ */
+void sortMedia(const MediaCatalog& catalog, vector<uint32_t>& rows, int left, int right) {
+	int i = left, j = right;
+	uint32_t mid = rows[(left + right) / 2];
+
+	while (i <= j) {
+		while (great(catalog, rows[i], mid)) i++;
+		while (great(catalog, mid, rows[j])) j--;
+
+		if (i <= j) {
+			swap(rows[i], rows[j]);
+			i++;
+			j--;
 		}
 	}
-	return newVec;
+
+	if (left < j) sortMedia(catalog, rows, left, j);
+	if (i < right) sortMedia(catalog, rows, i, right);
 }
 
 /**
- * Выполняет поиск медиафайлов по имени.
+ * Размер блока сплошного прохода по столбцам: сначала векторизуемым
+ * циклом считается маска совпадений блока, затем по ней без ветвлений
+ * выписываются номера.
+ */
+const size_t SCAN_BLOCK = 1024;
+
+/**
+ * Выборка из каталога: список номеров записей (до 2^32).
+ * Выборка всего каталога номеров не хранит. Операции над временной
+ * выборкой сжимают её список на месте, поэтому цепочка вида
+ * catalog.all().filter(...).search(...).sorted() не создаёт промежуточных
+ * векторов. Выборка действительна, пока каталог не изменён.
+ */
+class MediaView {
+	const MediaCatalog* catalog;
+	vector<uint32_t> rows;
+	bool whole;
+
+	/**
+	 * Оставляет записи, для которых pred(номер) истинен, — в новом списке.
+	 */
+	template <class Pred>
+	MediaView select(Pred pred) const {
+		MediaView result(*catalog, vector<uint32_t>());
+		for (size_t i = 0; i < size(); ++i) {
+			if (pred(row(i))) result.rows.push_back(uint32_t(row(i)));
+		}
+		return result;
+	}
+
+	/**
+	 * Оставляет записи, для которых pred(номер) истинен, — сжимая свой список.
+	 */
+	template <class Pred>
+	MediaView selectInPlace(Pred pred) {
+		if (whole) return select(pred);
+		size_t kept = 0;
+		for (size_t i = 0; i < rows.size(); ++i) {
+			if (pred(rows[i])) rows[kept++] = rows[i];
+		}
+		rows.resize(kept);
+		return move(*this);
+	}
+
+	/**
+	 * Сплошной проход фильтра по столбцам типа и размера всего каталога.
+	 */
+	MediaView scanFilter(uint8_t code, double mb) const {
+		size_t n = catalog->size();
+		const uint8_t* types = catalog->typeData();
+		const double* mbs = catalog->mbData();
+		vector<uint32_t> found(n);
+		size_t count = 0;
+		uint8_t match[SCAN_BLOCK];
+		for (size_t begin = 0; begin < n; begin += SCAN_BLOCK) {
+			size_t len = min(SCAN_BLOCK, n - begin);
+			for (size_t i = 0; i < len; ++i) {
+				match[i] = uint8_t(types[begin + i] == code) & uint8_t(mb < mbs[begin + i]);
+			}
+			for (size_t i = 0; i < len; ++i) {
+				found[count] = uint32_t(begin + i);
+				count += match[i];
+			}
+		}
+		found.resize(count);
+		found.shrink_to_fit();
+		return MediaView(*catalog, move(found));
+	}
+
+	/**
+	 * Поиск подстроки сразу по всей арене имён: после каждого совпадения
+	 * номер записи находится по смещениям, и поиск продолжается со следующего имени.
+	 */
+	MediaView scanSearch(const string& name) const {
+		string_view arena = catalog->nameArena();
+		const uint64_t* offsets = catalog->nameOffsetData();
+		size_t n = catalog->size();
+		MediaView result(*catalog, vector<uint32_t>());
+		size_t pos = 0, next = 0;
+		while ((pos = arena.find(name, pos)) != string_view::npos) {
+			// Смещения из файла не проверялись: номер держится в [next, n), а поиск всегда идёт вперёд.
+			size_t r = size_t(upper_bound(offsets + next, offsets + n + 1, uint64_t(pos)) - offsets);
+			r = r > next ? r - 1 : next;
+			if (r >= n) break;
+			if (pos + name.size() <= offsets[r + 1]) {
+				result.rows.push_back(uint32_t(r));
+				pos = max(pos + 1, size_t(offsets[r + 1]));
+				next = r + 1;
+			} else {
+				// Совпадение захватывает следующее имя — ищем дальше внутри этой записи.
+				++pos;
+				next = r;
+			}
+		}
+		return result;
+	}
+
+	/**
+	 * Номера записей, упорядоченные по дате.
+	 */
+	void sortRows() {
+		if (whole) {
+			rows.resize(catalog->size());
+			for (size_t i = 0; i < rows.size(); ++i) rows[i] = uint32_t(i);
+			whole = false;
+		}
+		if (rows.size() > 1) sortMedia(*catalog, rows, 0, int(rows.size() - 1));
+	}
+
+public:
+	/** Выборка из всех записей каталога. */
+	explicit MediaView(const MediaCatalog& catalog) : catalog(&catalog), whole(true) {}
+
+	/** Выборка из перечисленных записей. */
+	MediaView(const MediaCatalog& catalog, vector<uint32_t> rows) : catalog(&catalog), rows(move(rows)), whole(false) {}
+
+	/** Каталог выборки. */
+	const MediaCatalog& source() const { return *catalog; }
+	/** Число записей в выборке. */
+	size_t size() const { return whole ? catalog->size() : rows.size(); }
+	bool empty() const { return size() == 0; }
+	/** Номер i-й записи выборки в каталоге. */
+	size_t row(size_t i) const { return whole ? i : rows[i]; }
+	/** Собирает i-ю запись выборки. */
+	MediaFile operator[](size_t i) const { return catalog->get(row(i)); }
+
+	/**
+	 * Фильтрует медиафайлы по типу и минимальному размеру.
+	 *
+	 * @param type Тип для фильтрации.
+	 * @param mb Минимальный размер.
+	 * @return Выборка медиафайлов, соответствующих условиям.
+	 */
+	MediaView filter(const string& type, double mb) const& {
+		int code = catalog->findType(type);
+		if (code < 0) return MediaView(*catalog, vector<uint32_t>());
+		if (whole) return scanFilter(uint8_t(code), mb);
+		return select([this, code, mb](size_t r) { return catalog->typeCode(r) == code && mb < catalog->mb(r); });
+	}
+	MediaView filter(const string& type, double mb) && {
+		int code = catalog->findType(type);
+		if (code < 0) return MediaView(*catalog, vector<uint32_t>());
+		if (whole) return scanFilter(uint8_t(code), mb);
+		return selectInPlace([this, code, mb](size_t r) { return catalog->typeCode(r) == code && mb < catalog->mb(r); });
+	}
+
+	/**
+	 * Выполняет поиск медиафайлов по имени.
+	 *
+	 * @param name Подстрока для поиска в имени файла.
+	 * @return Выборка медиафайлов, в имени которых есть name.
+	 */
+	MediaView search(const string& name) const& {
+		if (whole && !name.empty()) return scanSearch(name);
+		return select([this, &name](size_t r) { return catalog->filename(r).find(name) != string_view::npos; });
+	}
+	MediaView search(const string& name) && {
+		if (whole && !name.empty()) return scanSearch(name);
+		return selectInPlace([this, &name](size_t r) { return catalog->filename(r).find(name) != string_view::npos; });
+	}
+
+	/**
+	 * Упорядочивает выборку по дате (см. great).
+	 *
+	 * @return Упорядоченная выборка.
+	 */
+	MediaView sorted() const& {
+		MediaView result(*this);
+		result.sortRows();
+		return result;
+	}
+	MediaView sorted() && {
+		sortRows();
+		return move(*this);
+	}
+
+	/**
+	 * Число записей выборки каждого типа: проход по однобайтовому столбцу типов.
+	 *
+	 * @return Счётчики по кодам типов (размер — число типов в словаре).
+	 */
+	vector<size_t> typeCounts() const {
+		size_t counts[MEDIA_TYPE_LIMIT] = {};
+		const uint8_t* types = catalog->typeData();
+		if (whole) {
+			for (size_t i = 0; i < catalog->size(); ++i) ++counts[types[i]];
+		} else {
+			for (uint32_t r : rows) ++counts[types[r]];
+		}
+		return vector<size_t>(counts, counts + catalog->typeCount());
+	}
+};
+
+MediaView MediaCatalog::all() const {
+	return MediaView(*this);
+}
+
+void MediaCatalog::sort() {
+	MediaView order = all().sorted();
+	size_t n = size();
+	vector<int32_t> sortedIds(n);
+	vector<double> sortedMbs(n);
+	vector<uint8_t> sortedTypes(n);
+	vector<uint32_t> sortedDates(n);
+	string sortedNames;
+	vector<uint64_t> sortedOffsets(n + 1, 0);
+	sortedNames.reserve(nameArena().size());
+	for (size_t i = 0; i < n; ++i) {
+		size_t r = order.row(i);
+		sortedIds[i] = id(r);
+		sortedMbs[i] = mb(r);
+		sortedTypes[i] = typeCode(r);
+		sortedDates[i] = packedDate(r);
+		sortedNames += filename(r);
+		sortedOffsets[i + 1] = sortedNames.size();
+	}
+	file.reset();
+	mapped = {};
+	ids.swap(sortedIds);
+	mbs.swap(sortedMbs);
+	types.swap(sortedTypes);
+	dates.swap(sortedDates);
+	names.swap(sortedNames);
+	nameOffsets.swap(sortedOffsets);
+}
+
+/**
+ * Выводит на экран список медиафайлов.
  *
- * @param vec Вектор медиафайлов.
+ * @param view Выборка медиафайлов.
+ */
+void printArr(const MediaView& view) {
+	const MediaCatalog& catalog = view.source();
+	for (size_t i = 0; i < view.size(); ++i) {
+		size_t r = view.row(i);
+		string_view name = catalog.filename(r);
+		Date date = catalog.date(r);
+		printf("\n\nId: %d \nИмя: %.*s \nПамять: %f \nТип: %s \nДата: %d.%d.%d ",
+			catalog.id(r), int(name.size()), name.data(), catalog.mb(r),
+			catalog.type(r).c_str(), date.day, date.month, date.year);
+	}
+}
+
+/**
+ * Выполняет поиск медиафайлов по имени и выводит найденные.
+ *
+ * @param view Выборка медиафайлов.
  * @param name Подстрока для поиска в имени файла.
  */
-void searchName(vector<MediaFile> vec, string name) {
-	for (int i = 0; i < vec.size(); ++i) {
-		if (vec[i].filename.find(name) != string::npos) {
-			printf("Id: %d | name: %s", vec[i].id, vec[i].filename.c_str());
-		}
+void searchName(const MediaView& view, const string& name) {
+	MediaView found = view.search(name);
+	const MediaCatalog& catalog = found.source();
+	for (size_t i = 0; i < found.size(); ++i) {
+		string_view filename = catalog.filename(found.row(i));
+		printf("Id: %d | name: %.*s\n", catalog.id(found.row(i)), int(filename.size()), filename.data());
 	}
 }
 
@@ -152,8 +664,8 @@ void searchName(vector<MediaFile> vec, string name) {
  *
  * @param distr Словарь, где ключ — тип, значение — количество.
  */
-void printCountType(map<string, int> distr) {
-	for (auto m : distr) {
+void printCountType(const map<string, int>& distr) {
+	for (const auto& m : distr) {
 		printf("%s : %d\n", m.first.c_str(), m.second);
 	}
 }
@@ -161,112 +673,554 @@ void printCountType(map<string, int> distr) {
 /**
  * Подсчитывает количество медиафайлов каждого типа и выводит результат.
  *
- * @param vec Вектор медиафайлов.
+ * @param view Выборка медиафайлов.
  */
-void distribution(vector<MediaFile> vec) {
+void distribution(const MediaView& view) {
+	vector<size_t> counts = view.typeCounts();
 	map<string, int> distr;
-	for (auto media : vec) {
-		++distr[media.type];
+	for (size_t code = 0; code < counts.size(); ++code) {
+		if (counts[code] > 0) distr[view.source().typeName(uint8_t(code))] = int(counts[code]);
 	}
 	printCountType(distr);
 }
 
 /**
- * Сравнивает два медиафайла по дате.
- * Если даты совпадают — сравнение по имени.
+ * Сохраняет медиафайлы в файл "media.txt".
  *
- * @param a Первый медиафайл.
- * @param b Второй медиафайл.
- * @return true, если a больше b, иначе false.
+ * @param view Выборка медиафайлов.
+ */
+void saveMedia(const MediaView& view) {
+	ofstream out("media.txt");
+	const MediaCatalog& catalog = view.source();
+	for (size_t i = 0; i < view.size(); i++) {
+		size_t r = view.row(i);
+		Date date = catalog.date(r);
+		out << catalog.id(r) << " "
+			<< catalog.filename(r) << " "
+			<< catalog.mb(r) << " "
+			<< catalog.type(r) << " "
+			<< date.day << " "
+			<< date.month << " "
+			<< date.year << "\n";
+	}
+	out.close();
+}
+
+/**
+ * Файл, отображённый в память только для чтения. Страницы отображения
+ * общие для всех процессов, открывших файл.
+ */
+class MappedFile {
+	const char* ptr = nullptr;
+	size_t len = 0;
+	bool opened = false;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#endif
+public:
+	/**
+	 * Отображает файл в память.
+	 *
+	 * @param path Путь к файлу.
+	 */
+	explicit MappedFile(const string& path) {
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE) return;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) return;
+		if (size.QuadPart == 0) { opened = true; return; }
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!mapping) return;
+		ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (ptr) { len = size_t(size.QuadPart); opened = true; }
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) return;
+		struct stat st;
+		if (fstat(fd, &st) == 0) {
+			if (st.st_size == 0) opened = true;
+			else {
+				void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+				if (p != MAP_FAILED) {
+					ptr = (const char*)p;
+					len = size_t(st.st_size);
+					opened = true;
+				}
+			}
+		}
+		close(fd);
+#endif
+	}
+
+	~MappedFile() {
+#ifdef _WIN32
+		if (ptr) UnmapViewOfFile(ptr);
+		if (mapping) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+		if (ptr) munmap((void*)ptr, len);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/** Открылся ли файл (пустой файл открывается без отображения). */
+	bool isOpen() const { return opened; }
+	/** Начало данных или nullptr для пустого файла. */
+	const char* data() const { return ptr; }
+	/** Размер файла в байтах. */
+	size_t size() const { return len; }
+};
+
+/**
+ * Ошибка в строке текстового файла медиатеки.
+ */
+struct ParseError {
+	size_t line;
+	string message;
+};
+
+/**
+ * Пропускает пробелы и табуляции.
+ */
+const char* skipSpaces(const char* p, const char* end) {
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+	return p;
+}
+
+/**
+ * Возвращает конец слова, начинающегося в p.
  */
-bool great(const MediaFile& a, const MediaFile& b) {
-	if (a.creation_date.year != b.creation_date.year) return a.creation_date.year > b.creation_date.year;
-	if (a.creation_date.month != b.creation_date.month) return a.creation_date.month > b.creation_date.month;
-	if (a.creation_date.day != b.creation_date.day) return a.creation_date.day > b.creation_date.day;
-	return a.filename < b.filename;
+const char* wordEnd(const char* p, const char* end) {
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+	return p;
 }
 
 /**
- * Сортировка вектора медиафайлов.
+ * Читает число из следующего слова строки.
  *
- * @param vec Вектор медиафайлов.
- * @param left Левая граница.
- * @param right Правая граница.
+ * @return true, если слово целиком — число.
  */
-void sortMedia(vector<MediaFile>& vec, int left, int right) {
-	int i = left, j = right;
-	MediaFile mid = vec[(left + right) / 2];
+template <class T>
+bool parseField(const char*& p, const char* end, T& value) {
+	p = skipSpaces(p, end);
+	const char* stop = wordEnd(p, end);
+	from_chars_result result = from_chars(p, stop, value);
+	if (result.ec != errc() || result.ptr != stop || p == stop) return false;
+	p = stop;
+	return true;
+}
 
-	while (i <= j) {
-		while (great(vec[i], mid)) i++;
-		while (great(mid, vec[j])) j--;
+/**
+ * Читает следующее слово строки.
+ *
+ * @return true, если слово не пустое.
+ */
+bool parseField(const char*& p, const char* end, string& value) {
+	p = skipSpaces(p, end);
+	const char* stop = wordEnd(p, end);
+	if (p == stop) return false;
+	value.assign(p, stop);
+	p = stop;
+	return true;
+}
 
-		if (i <= j) {
-			MediaFile tmp = vec[i];
-			vec[i] = vec[j];
-			vec[j] = tmp;
-			i++;
-			j--;
-		}
-	}
+/**
+ * Разбирает строку формата saveMedia: "id имя размер тип день месяц год".
+ *
+ * @param begin Начало строки.
+ * @param end Конец строки (без перевода строки).
+ * @param media Результат.
+ * @return Пустая строка при успехе, иначе описание ошибки.
+ */
+const char* parseMediaLine(const char* begin, const char* end, MediaFile& media) {
+	const char* p = begin;
+	if (!parseField(p, end, media.id)) return "неверный id";
+	if (!parseField(p, end, media.filename)) return "нет имени";
+	if (!parseField(p, end, media.mb)) return "неверный размер";
+	if (!parseField(p, end, media.type)) return "нет типа";
+	if (!parseField(p, end, media.creation_date.day)) return "неверный день";
+	if (!parseField(p, end, media.creation_date.month)) return "неверный месяц";
+	if (!parseField(p, end, media.creation_date.year)) return "неверный год";
+	if (!isPackableDate(media.creation_date)) return "неверная дата";
+	if (skipSpaces(p, end) != end) return "лишние поля";
+	return "";
+}
 
-	if (left < j) sortMedia(vec, left, j);
-	if (i < right) sortMedia(vec, i, right);
+/**
+ * Является ли строка пустой (только пробелы).
+ */
+bool isBlankLine(const char* begin, const char* end) {
+	return skipSpaces(begin, end) == end;
 }
 
 /**
- * Сортирует медиафайлы с использованием быстрой сортировки.
+ * Быстрый импорт текстового файла медиатеки.
+ * Файл отображается в память и делится на части по границам строк.
+ * Сначала в каждой части считаются строки, чтобы заранее выделить вектор
+ * на все записи. Затем части разбираются параллельно через from_chars,
+ * каждая запись сразу кладётся на своё место. Пустые и ошибочные строки
+ * в конце убираются, а ошибки возвращаются с номерами строк.
  *
- * @param vec Вектор медиафайлов.
- * @return Отсортированный вектор медиафайлов.
+ * @param path Путь к файлу.
+ * @param errors Ошибочные строки.
+ * @param threads Число потоков, 0 — по числу ядер.
+ * @return Вектор медиафайлов в порядке строк файла.
  */
-vector<MediaFile> sortirovkaMedia(vector<MediaFile> vec) {
-	if (!vec.empty()) {
-		sortMedia(vec, 0, vec.size() - 1);
+vector<MediaFile> importMedia(const string& path, vector<ParseError>& errors, unsigned threads = 0) {
+	errors.clear();
+	MappedFile file(path);
+	vector<MediaFile> vec;
+	if (!file.isOpen() || file.size() == 0) return vec;
+	const char* data = file.data();
+	size_t size = file.size();
+
+	if (threads == 0) threads = thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	const size_t minChunk = size_t(1) << 20;
+	if (threads > size / minChunk + 1) threads = unsigned(size / minChunk + 1);
+
+	// Границы частей сдвигаются на начало следующей строки.
+	vector<size_t> bounds(threads + 1, size);
+	bounds[0] = 0;
+	for (unsigned t = 1; t < threads; ++t) {
+		size_t pos = max(bounds[t - 1], size / threads * t);
+		const char* nl = pos < size ? (const char*)memchr(data + pos, '\n', size - pos) : nullptr;
+		bounds[t] = nl ? size_t(nl - data) + 1 : size;
+	}
+
+	auto runParallel = [threads](auto work) {
+		vector<thread> pool;
+		for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work, t);
+		work(0u);
+		for (auto& th : pool) th.join();
+	};
+
+	vector<size_t> firstLine(threads + 1, 0);
+	runParallel([&](unsigned t) {
+		size_t lines = 0;
+		const char* p = data + bounds[t];
+		const char* end = data + bounds[t + 1];
+		while (p < end) {
+			const char* nl = (const char*)memchr(p, '\n', size_t(end - p));
+			++lines;
+			p = nl ? nl + 1 : end;
+		}
+		firstLine[t + 1] = lines;
+	});
+	for (unsigned t = 0; t < threads; ++t) firstLine[t + 1] += firstLine[t];
+
+	vec.resize(firstLine[threads]);
+	vector<char> valid(vec.size(), 0);
+	vector<vector<ParseError>> localErrors(threads);
+	runParallel([&](unsigned t) {
+		size_t line = firstLine[t];
+		const char* p = data + bounds[t];
+		const char* end = data + bounds[t + 1];
+		while (p < end) {
+			const char* nl = (const char*)memchr(p, '\n', size_t(end - p));
+			const char* lineEnd = nl ? nl : end;
+			if (!isBlankLine(p, lineEnd)) {
+				const char* error = parseMediaLine(p, lineEnd, vec[line]);
+				if (*error) localErrors[t].push_back({ line + 1, error });
+				else valid[line] = 1;
+			}
+			++line;
+			p = nl ? nl + 1 : end;
+		}
+	});
+
+	size_t kept = 0;
+	for (size_t i = 0; i < vec.size(); ++i) {
+		if (!valid[i]) continue;
+		if (kept != i) vec[kept] = move(vec[i]);
+		++kept;
 	}
+	vec.resize(kept);
+	for (auto& local : localErrors) errors.insert(errors.end(), local.begin(), local.end());
 	return vec;
 }
 
 /**
- * Сохраняет медиафайлы в файл "media.txt".
+ * Загружает медиафайлы из файла "media.txt".
  *
- * @param vec Вектор медиафайлов.
+ * @return Каталог загруженных медиафайлов.
  */
-void saveMedia(vector<MediaFile> vec) {
-	ofstream out("media.txt");
-	for (int i = 0; i < vec.size(); i++) {
-		out << vec[i].id << " "
-			<< vec[i].filename << " "
-			<< vec[i].mb << " "
-			<< vec[i].type << " "
-			<< vec[i].creation_date.day << " "
-			<< vec[i].creation_date.month << " "
-			<< vec[i].creation_date.year << "\n";
+MediaCatalog loadMedia() {
+	vector<ParseError> errors;
+	MediaCatalog catalog(importMedia("media.txt", errors));
+	for (const ParseError& error : errors) {
+		printf("media.txt:%zu: %s\n", error.line, error.message.c_str());
 	}
-	out.close();
+	cout << "\nЗагруженный файл:\n ";
+	printArr(catalog.all());
+	return catalog;
 }
 
+
+
 /**
- * Загружает медиафайлы из файла "media.txt".
+ * Заголовок двоичного файла медиатеки.
+ * За заголовком идут столбцы, каждый с границы 8 байт, в том же виде,
+ * что и в памяти каталога: id (int32), размер (double), упакованная дата
+ * (uint32, см. packDate), код типа (uint8), смещения имён (uint64, count + 1),
+ * смещения названий типов (uint64, typeCount + 1) и куча строк, где подряд
+ * лежат имена файлов и названия типов в порядке кодов.
+ * Смещения столбцов отсчитываются от начала файла, смещения строк — от начала кучи.
+ */
+struct MediaFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint64_t count;
+	uint64_t typeCount;
+	uint64_t idOffset;
+	uint64_t mbOffset;
+	uint64_t dateOffset;
+	uint64_t typeOffset;
+	uint64_t nameOffsetsOffset;
+	uint64_t typeNamesOffset;
+	uint64_t heapOffset;
+	uint64_t heapSize;
+};
+
+const char MEDIA_MAGIC[8] = { 'M', 'E', 'D', 'I', 'A', 'C', 'O', 'L' };
+const uint32_t MEDIA_VERSION = 2;
+
+/**
+ * Округляет смещение вверх до границы 8 байт.
+ */
+uint64_t alignColumn(uint64_t offset) {
+	return (offset + 7) & ~uint64_t(7);
+}
+
+/**
+ * Записывает столбец по заданному смещению, дополняя файл нулями до него.
  *
- * @return Вектор загруженных медиафайлов.
+ * @param out Поток файла.
+ * @param offset Смещение столбца.
+ * @param data Данные столбца.
+ * @param bytes Размер столбца в байтах.
  */
-vector<MediaFile> loadMedia() {
-	ifstream in("media.txt");
-	vector<MediaFile> vec;
-	MediaFile media;
-	while (in >> media.id >> media.filename >> media.mb >> media.type
-		>> media.creation_date.day >> media.creation_date.month >> media.creation_date.year) {
-		vec.push_back(media);
+void writeColumn(ofstream& out, uint64_t offset, const void* data, size_t bytes) {
+	static const char zeros[8] = {};
+	uint64_t pos = uint64_t(out.tellp());
+	if (offset > pos) out.write(zeros, streamsize(offset - pos));
+	out.write((const char*)data, streamsize(bytes));
+}
+
+/**
+ * Сохраняет медиафайлы в двоичный столбцовый файл.
+ * Одинаковые названия типов хранятся в куче один раз.
+ *
+ * @param view Выборка медиафайлов.
+ * @param path Путь к файлу.
+ * @return true, если файл записан.
+ */
+bool saveMediaBinary(const MediaView& view, const string& path) {
+	size_t n = view.size();
+	vector<int32_t> ids(n);
+	vector<double> mbs(n);
+	vector<uint32_t> dates(n);
+	vector<uint8_t> types(n);
+	vector<uint64_t> nameOffsets(n + 1);
+	const MediaCatalog& catalog = view.source();
+	size_t typeCount = catalog.typeCount();
+	string heap;
+
+	size_t nameBytes = 0;
+	for (size_t i = 0; i < n; ++i) nameBytes += catalog.filename(view.row(i)).size();
+	heap.reserve(nameBytes);
+	// Номера типов в файле — коды словаря каталога.
+	for (size_t i = 0; i < n; ++i) {
+		size_t r = view.row(i);
+		ids[i] = catalog.id(r);
+		mbs[i] = catalog.mb(r);
+		dates[i] = catalog.packedDate(r);
+		types[i] = catalog.typeCode(r);
+		nameOffsets[i] = heap.size();
+		heap += catalog.filename(r);
 	}
+	nameOffsets[n] = heap.size();
+	vector<uint64_t> typeNameOffsets(typeCount + 1);
+	for (size_t t = 0; t < typeCount; ++t) {
+		typeNameOffsets[t] = heap.size();
+		heap += catalog.typeName(uint8_t(t));
+	}
+	typeNameOffsets[typeCount] = heap.size();
 
-	in.close();
-	cout << "\nЗагруженный файл:\n ";
-	printArr(vec);
-	return vec;
+	MediaFileHeader header = {};
+	memcpy(header.magic, MEDIA_MAGIC, sizeof(MEDIA_MAGIC));
+	header.version = MEDIA_VERSION;
+	header.headerSize = sizeof(MediaFileHeader);
+	header.count = n;
+	header.typeCount = typeCount;
+	header.idOffset = alignColumn(sizeof(MediaFileHeader));
+	header.mbOffset = alignColumn(header.idOffset + n * sizeof(int32_t));
+	header.dateOffset = alignColumn(header.mbOffset + n * sizeof(double));
+	header.typeOffset = alignColumn(header.dateOffset + n * sizeof(uint32_t));
+	header.nameOffsetsOffset = alignColumn(header.typeOffset + n * sizeof(uint8_t));
+	header.typeNamesOffset = alignColumn(header.nameOffsetsOffset + (n + 1) * sizeof(uint64_t));
+	header.heapOffset = alignColumn(header.typeNamesOffset + typeNameOffsets.size() * sizeof(uint64_t));
+	header.heapSize = heap.size();
+
+	ofstream out(path, ios::binary | ios::trunc);
+	if (!out) return false;
+	out.write((const char*)&header, sizeof(header));
+	writeColumn(out, header.idOffset, ids.data(), n * sizeof(int32_t));
+	writeColumn(out, header.mbOffset, mbs.data(), n * sizeof(double));
+	writeColumn(out, header.dateOffset, dates.data(), n * sizeof(uint32_t));
+	writeColumn(out, header.typeOffset, types.data(), n * sizeof(uint8_t));
+	writeColumn(out, header.nameOffsetsOffset, nameOffsets.data(), nameOffsets.size() * sizeof(uint64_t));
+	writeColumn(out, header.typeNamesOffset, typeNameOffsets.data(), typeNameOffsets.size() * sizeof(uint64_t));
+	writeColumn(out, header.heapOffset, heap.data(), heap.size());
+	return bool(out);
 }
 
+/**
+ * Двоичный файл медиатеки, отображённый в память только для чтения.
+ * Столбцы читаются прямо из отображения без разбора, а страницы файла
+ * делятся между всеми процессами, открывшими его.
+ */
+class MediaFileMap {
+	MappedFile file;
+	const char* ptr = nullptr;
+	size_t len = 0;
+	const MediaFileHeader* header = nullptr;
+
+	/**
+	 * Проверяет, что столбец из count элементов размера width лежит внутри файла.
+	 */
+	bool columnFits(uint64_t offset, uint64_t count, uint64_t width) const {
+		return offset % 8 == 0 && offset <= len && count <= (len - offset) / width;
+	}
+
+	/**
+	 * Проверяет заголовок: сигнатуру, версию и границы всех столбцов.
+	 */
+	bool validate() const {
+		const MediaFileHeader* h = (const MediaFileHeader*)ptr;
+		if (len < sizeof(MediaFileHeader)) return false;
+		if (memcmp(h->magic, MEDIA_MAGIC, sizeof(MEDIA_MAGIC)) != 0) return false;
+		if (h->version != MEDIA_VERSION || h->headerSize != sizeof(MediaFileHeader)) return false;
+		if (h->count >= UINT64_MAX / 16 || h->typeCount >= UINT32_MAX) return false;
+		return columnFits(h->idOffset, h->count, sizeof(int32_t))
+			&& columnFits(h->mbOffset, h->count, sizeof(double))
+			&& columnFits(h->dateOffset, h->count, sizeof(uint32_t))
+			&& columnFits(h->typeOffset, h->count, sizeof(uint8_t))
+			&& columnFits(h->nameOffsetsOffset, h->count + 1, sizeof(uint64_t))
+			&& columnFits(h->typeNamesOffset, h->typeCount + 1, sizeof(uint64_t))
+			&& h->heapOffset <= len && h->heapSize <= len - h->heapOffset;
+	}
+
+	/**
+	 * Строка кучи [begin, end); при испорченных смещениях — пустая строка.
+	 */
+	string_view heapString(uint64_t begin, uint64_t end) const {
+		if (begin > end || end > header->heapSize) return string_view();
+		return string_view(ptr + header->heapOffset + begin, size_t(end - begin));
+	}
+
+public:
+	/**
+	 * Отображает файл в память и проверяет заголовок.
+	 *
+	 * @param path Путь к файлу.
+	 */
+	explicit MediaFileMap(const string& path) : file(path), ptr(file.data()), len(file.size()) {
+		if (ptr && validate()) header = (const MediaFileHeader*)ptr;
+	}
+
+	/** Открылся ли файл и верен ли его заголовок. */
+	bool isOpen() const { return header != nullptr; }
+	/** Число медиафайлов. */
+	size_t size() const { return header ? size_t(header->count) : 0; }
+	/** Число разных типов. */
+	size_t typeCount() const { return header ? size_t(header->typeCount) : 0; }
+
+	const int32_t* ids() const { return (const int32_t*)(ptr + header->idOffset); }
+	const double* mbs() const { return (const double*)(ptr + header->mbOffset); }
+	const uint32_t* dates() const { return (const uint32_t*)(ptr + header->dateOffset); }
+	const uint8_t* types() const { return (const uint8_t*)(ptr + header->typeOffset); }
+	/** Смещения имён в куче (size() + 1) и сама куча. */
+	const uint64_t* nameOffsets() const { return (const uint64_t*)(ptr + header->nameOffsetsOffset); }
+	const char* heap() const { return ptr + header->heapOffset; }
+	uint64_t heapSize() const { return header->heapSize; }
+
+	/** Имя i-го файла. */
+	string_view filename(size_t i) const {
+		const uint64_t* offsets = (const uint64_t*)(ptr + header->nameOffsetsOffset);
+		return heapString(offsets[i], offsets[i + 1]);
+	}
+
+	/** Название типа с номером t. */
+	string_view typeName(size_t t) const {
+		if (t >= header->typeCount) return string_view();
+		const uint64_t* offsets = (const uint64_t*)(ptr + header->typeNamesOffset);
+		return heapString(offsets[t], offsets[t + 1]);
+	}
 
+	/** Тип i-го файла. */
+	string_view type(size_t i) const { return typeName(types()[i]); }
+
+	/** Собирает i-й медиафайл. */
+	MediaFile get(size_t i) const {
+		MediaFile media;
+		media.id = ids()[i];
+		media.filename = string(filename(i));
+		media.mb = mbs()[i];
+		media.type = string(type(i));
+		media.creation_date = unpackDate(dates()[i]);
+		return media;
+	}
+};
+
+bool MediaCatalog::assign(shared_ptr<const MediaFileMap> source) {
+	*this = MediaCatalog();
+	size_t n = source->size();
+	const uint64_t* offsets = source->nameOffsets();
+	if (offsets[0] != 0 || offsets[n] > source->heapSize()) return false;
+	if (source->typeCount() > MEDIA_TYPE_LIMIT) return false;
+	// Коды типов в файле — номера в его словаре, поэтому словарь каталога повторяет его.
+	typeNames.clear();
+	typeCodes.clear();
+	for (size_t t = 0; t < source->typeCount(); ++t) {
+		if (internType(source->typeName(t)) != t) return false;
+	}
+	mapped.ids = source->ids();
+	mapped.mbs = source->mbs();
+	mapped.types = source->types();
+	mapped.dates = source->dates();
+	mapped.nameOffsets = offsets;
+	mapped.names = source->heap();
+	mapped.count = n;
+	mapped.nameBytes = size_t(offsets[n]);
+	file = move(source);
+	return true;
+}
+
+/**
+ * Загружает медиафайлы из двоичного файла. Записи не копируются:
+ * каталог читает столбцы из отображения, общего для всех процессов.
+ *
+ * @param path Путь к файлу.
+ * @return Каталог загруженных медиафайлов (пустой, если файл не открылся).
+ */
+MediaCatalog loadMediaBinary(const string& path) {
+	auto mapped = make_shared<const MediaFileMap>(path);
+	MediaCatalog catalog;
+	if (!mapped->isOpen()) {
+		cout << "Не удалось открыть " << path << "\n";
+	}
+	else if (!catalog.assign(mapped)) {
+		cout << "Файл " << path << " повреждён\n";
+		catalog = MediaCatalog();
+	}
+	return catalog;
+}
 
 /**Меню выбора действий
 *
@@ -282,6 +1236,8 @@ int menu() {
 	cout << "6. Показать распределение по типам\n";
 	cout << "7. Сохранить в файл\n";
 	cout << "8. Загрузить из файла\n";
+	cout << "9. Сохранить в двоичный файл\n";
+	cout << "10. Загрузить из двоичного файла\n";
 	cout << "0. Выход\n";
 	int choice;
 	cin >> choice;
@@ -292,7 +1248,7 @@ int main() {
 	setlocale(LC_ALL, "RUS");
 	srand(time(NULL));
 
-	vector<MediaFile> arr, newArr, fileArr;      
+	MediaCatalog catalog, fileCatalog;
 	int choice;
 	while (true) {
 		choice = menu();
@@ -305,52 +1261,59 @@ int main() {
 			int n;
 			cout << "Число N: ";
 			cin >> n;
-			arr = randomGenerateMediaFile(n);
+			catalog = MediaCatalog(randomGenerateMediaFile(n));
 			break;
 		}
 		case 2:
-			if (arr.empty()) cout << "Нет данных.\n";
-			else printArr(arr);
+			if (catalog.empty()) cout << "Нет данных.\n";
+			else printArr(catalog.all());
 			break;
 		case 3:
-			if (!arr.empty()) {
-				arr = sortirovkaMedia(arr);
+			if (!catalog.empty()) {
+				catalog.sort();
 			}
 			else cout << "Нет данных.\n";
 			break;
 		case 4: {
-			if (arr.empty()) { cout << "Нет данных.\n"; break; }
+			if (catalog.empty()) { cout << "Нет данных.\n"; break; }
 			string name;
 			cout << "Имя: ";
 			cin >> name;
-			searchName(arr, name);
+			searchName(catalog.all(), name);
 			break;
 		}
 		case 5: {
-			if (arr.empty()) { cout << "Нет данных.\n"; break; }
+			if (catalog.empty()) { cout << "Нет данных.\n"; break; }
 			string type;
 			double mb;
 			cout << "Введите тип: ";
 			cin >> type;
 			cout << "Размер: ";
 			cin >> mb;
-			newArr = filter(arr, type, mb);
-			printArr(newArr);
+			printArr(catalog.all().filter(type, mb));
 			break;
 		}
 		case 6:
-			if (arr.empty()) cout << "Нет данных.\n";
-			else distribution(arr);
+			if (catalog.empty()) cout << "Нет данных.\n";
+			else distribution(catalog.all());
 			break;
 		case 7:
-			if (!arr.empty()) {
-				saveMedia(arr);
+			if (!catalog.empty()) {
+				saveMedia(catalog.all());
 			}
 			else cout << "Нет данных.\n";
 			break;
 		case 8:
-			fileArr = loadMedia();
-			printArr(fileArr);
+			fileCatalog = loadMedia();
+			printArr(fileCatalog.all());
+			break;
+		case 9:
+			if (catalog.empty()) cout << "Нет данных.\n";
+			else if (!saveMediaBinary(catalog.all(), "media.bin")) cout << "Ошибка записи media.bin\n";
+			break;
+		case 10:
+			catalog = loadMediaBinary("media.bin");
+			cout << "Загружено медиафайлов: " << catalog.size() << "\n";
 			break;
 		default:
 			cout << "Неверный выбор.\n";